@@ -0,0 +1,92 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef N2T_ALU_H
+#define N2T_ALU_H
+
+#include <array>
+#include <cstdint>
+#include <utility>
+
+namespace n2t
+{
+// Computes the output of the ALU for the 7-bit 'comp' field of a C-instruction ('a' bit followed by 'c1' to 'c6'),
+// where the 'a' bit selects A or M as the 'y' input, and 'c1' to 'c6' are the 'zx', 'nx', 'zy', 'ny', 'f' and 'no'
+// control bits of the ALU chip. The control bits are template parameters, so that each instantiation reduces to
+// the few operations needed by its 'comp' code.
+template<uint16_t Comp>
+[[nodiscard]] constexpr uint16_t alu(uint16_t d, uint16_t a, uint16_t m) noexcept
+{
+    constexpr bool useM = (Comp & 0b1000000) != 0;
+    constexpr bool zx   = (Comp & 0b0100000) != 0;
+    constexpr bool nx   = (Comp & 0b0010000) != 0;
+    constexpr bool zy   = (Comp & 0b0001000) != 0;
+    constexpr bool ny   = (Comp & 0b0000100) != 0;
+    constexpr bool f    = (Comp & 0b0000010) != 0;
+    constexpr bool no   = (Comp & 0b0000001) != 0;
+
+    uint16_t x = zx ? uint16_t{0} : d;
+    uint16_t y = zy ? uint16_t{0} : (useM ? m : a);
+    if constexpr (nx)
+    {
+        x = static_cast<uint16_t>(~x);
+    }
+    if constexpr (ny)
+    {
+        y = static_cast<uint16_t>(~y);
+    }
+
+    auto out = f ? static_cast<uint16_t>(x + y) : static_cast<uint16_t>(x & y);
+    if constexpr (no)
+    {
+        out = static_cast<uint16_t>(~out);
+    }
+
+    return out;
+}
+
+using AluFunction = uint16_t (*)(uint16_t d, uint16_t a, uint16_t m) noexcept;
+
+namespace detail
+{
+template<std::size_t... Comps>
+[[nodiscard]] constexpr std::array<AluFunction, sizeof...(Comps)> makeAluTable(std::index_sequence<Comps...>) noexcept
+{
+    return {&alu<static_cast<uint16_t>(Comps)>...};
+}
+}  // namespace detail
+
+// ALU functions indexed by the 7-bit 'comp' field, including the codes that have no mnemonic.
+inline constexpr auto aluTable = detail::makeAluTable(std::make_index_sequence<128>{});
+
+// Returns whether a C-instruction with the given 3-bit 'jump' field jumps, given the output of the ALU.
+[[nodiscard]] constexpr bool jumps(uint16_t jump, uint16_t out) noexcept
+{
+    const auto value = static_cast<int16_t>(out);
+    const auto mask  = (value < 0) ? 0b100 : ((value == 0) ? 0b010 : 0b001);
+    return (jump & mask) != 0;
+}
+}  // namespace n2t
+
+#endif
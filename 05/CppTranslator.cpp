@@ -0,0 +1,505 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "CppTranslator.h"
+
+#include <Code.h>
+#include <Util.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace
+{
+constexpr uint16_t cInstructionBit = 0x8000;
+constexpr uint16_t compShift       = 6;
+constexpr uint16_t compMask        = 0x7F;
+constexpr uint16_t destShift       = 3;
+constexpr uint16_t destA           = 0b100000;
+constexpr uint16_t destD           = 0b010000;
+constexpr uint16_t destM           = 0b001000;
+constexpr uint16_t destMask        = 0b111000;
+constexpr uint16_t jumpMask        = 0b000111;
+constexpr uint16_t jumpAlways      = 0b111;
+
+// Conditions of the 'jump' field, on the signed output of the ALU.
+// clang-format off
+constexpr std::array<std::string_view, 8> jumpConditions =
+{
+    "false",
+    "s(out) > 0",
+    "out == 0",
+    "s(out) >= 0",
+    "s(out) < 0",
+    "out != 0",
+    "s(out) <= 0",
+    "true"
+};
+// clang-format on
+
+// Runtime of the generated program: the data memory, the ALU and the command line options. The ALU template is
+// the same as the one of the emulator, so that the C++ compiler reduces each instruction to a few operations.
+constexpr std::string_view runtime = R"(
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace
+{
+constexpr uint16_t addressMask = 0x7FFF;
+
+uint16_t ram[0x8000];
+
+template<uint16_t Comp>
+inline uint16_t alu(uint16_t d, uint16_t a, uint16_t m)
+{
+    constexpr bool useM = (Comp & 0b1000000) != 0;
+    constexpr bool zx   = (Comp & 0b0100000) != 0;
+    constexpr bool nx   = (Comp & 0b0010000) != 0;
+    constexpr bool zy   = (Comp & 0b0001000) != 0;
+    constexpr bool ny   = (Comp & 0b0000100) != 0;
+    constexpr bool f    = (Comp & 0b0000010) != 0;
+    constexpr bool no   = (Comp & 0b0000001) != 0;
+
+    uint16_t x = zx ? uint16_t{0} : d;
+    uint16_t y = zy ? uint16_t{0} : (useM ? m : a);
+    x = nx ? static_cast<uint16_t>(~x) : x;
+    y = ny ? static_cast<uint16_t>(~y) : y;
+    const auto out = f ? static_cast<uint16_t>(x + y) : static_cast<uint16_t>(x & y);
+    return no ? static_cast<uint16_t>(~out) : out;
+}
+
+inline int16_t s(uint16_t value)
+{
+    return static_cast<int16_t>(value);
+}
+
+// Executes an instruction decoded at run time, and returns the address of the next instruction.
+[[maybe_unused]] uint16_t execute(uint16_t instruction, uint16_t& a, uint16_t& d, uint16_t pc)
+{
+    if ((instruction & 0x8000) == 0)
+    {
+        a = instruction;
+        return static_cast<uint16_t>(pc + 1);
+    }
+
+    const uint16_t comp    = (instruction >> 6) & 0x7F;
+    const uint16_t operand = ((comp & 0b1000000) != 0) ? ram[a & addressMask] : a;
+    uint16_t       x       = ((comp & 0b0100000) != 0) ? uint16_t{0} : d;
+    uint16_t       y       = ((comp & 0b0001000) != 0) ? uint16_t{0} : operand;
+    x = ((comp & 0b0010000) != 0) ? static_cast<uint16_t>(~x) : x;
+    y = ((comp & 0b0000100) != 0) ? static_cast<uint16_t>(~y) : y;
+    auto out = ((comp & 0b0000010) != 0) ? static_cast<uint16_t>(x + y) : static_cast<uint16_t>(x & y);
+    out      = ((comp & 0b0000001) != 0) ? static_cast<uint16_t>(~out) : out;
+
+    const uint16_t target = a & addressMask;
+    if ((instruction & 0b001000) != 0)
+    {
+        ram[a & addressMask] = out;
+    }
+    if ((instruction & 0b010000) != 0)
+    {
+        d = out;
+    }
+    if ((instruction & 0b100000) != 0)
+    {
+        a = out;
+    }
+
+    const bool jump = (((instruction & 0b100) != 0) && (s(out) < 0)) || (((instruction & 0b010) != 0) && (out == 0)) ||
+                      (((instruction & 0b001) != 0) && (s(out) > 0));
+    return jump ? target : static_cast<uint16_t>(pc + 1);
+}
+
+bool parseArguments(int                                         argc,
+                    char*                                       argv[],
+                    uint64_t&                                   maxCycles,
+                    bool&                                       quiet,
+                    std::vector<std::pair<unsigned, unsigned>>& ranges)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        unsigned first = 0;
+        unsigned last  = 0;
+        int      value = 0;
+        if (std::strcmp(argv[i], "-q") == 0)
+        {
+            quiet = true;
+        }
+        else if ((std::strcmp(argv[i], "-c") == 0) && ((i + 1) < argc))
+        {
+            maxCycles = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if ((std::strcmp(argv[i], "-s") == 0) && ((i + 1) < argc) &&
+                 (std::sscanf(argv[++i], "%u=%d", &first, &value) == 2) && (first <= addressMask))
+        {
+            ram[first] = static_cast<uint16_t>(value);
+        }
+        else if ((std::strcmp(argv[i], "-r") == 0) && ((i + 1) < argc))
+        {
+            const auto count = std::sscanf(argv[++i], "%u:%u", &first, &last);
+            if ((count < 1) || (first > addressMask) || ((count == 2) && ((last < first) || (last > addressMask))))
+            {
+                return false;
+            }
+            ranges.emplace_back(first, (count == 2) ? last : first);
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+}  // namespace
+)";
+
+// Start of the main function, up to the jump to the first block.
+constexpr std::string_view mainPrologue = R"(
+int main(int argc, char* argv[])
+{
+    uint64_t                                   maxCycles = UINT64_MAX;
+    bool                                       quiet     = false;
+    std::vector<std::pair<unsigned, unsigned>> ranges;
+    if (!parseArguments(argc, argv, maxCycles, quiet, ranges))
+    {
+        std::fprintf(stderr, "usage: %s [-q] [-c cycles] [-s address=value]... [-r first[:last]]...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    uint16_t   a         = 0;
+    uint16_t   d         = 0;
+    uint16_t   pc        = 0;
+    uint64_t   cycles    = 0;
+    bool       halted    = false;
+    const auto startTime = std::chrono::steady_clock::now();
+
+    goto L0;
+)";
+
+constexpr std::string_view epilogue = R"(
+stop:
+    const auto elapsedTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    for (const auto& [first, last] : ranges)
+    {
+        for (auto address = first; address <= last; ++address)
+        {
+            std::printf("RAM[%u] = %d\n", address, s(ram[address]));
+        }
+    }
+    if (!quiet)
+    {
+        std::printf("%s after %" PRIu64 " cycles in %.3f s (%.1f MIPS)\n",
+                    halted ? "Halted" : "Stopped",
+                    cycles,
+                    elapsedTime,
+                    (elapsedTime > 0) ? (static_cast<double>(cycles) / elapsedTime / 1e6) : 0.0);
+    }
+    static_cast<void>(a);
+    static_cast<void>(d);
+    static_cast<void>(pc);
+    return EXIT_SUCCESS;
+}
+)";
+
+// Returns the assembly mnemonic of an instruction, for comments.
+[[nodiscard]] std::string mnemonic(uint16_t instruction)
+{
+    if ((instruction & cInstructionBit) == 0)
+    {
+        return fmt::format("@{}", instruction);
+    }
+
+    try
+    {
+        const auto dest = n2t::Code::destMnemonic((instruction & destMask) >> destShift);
+        const auto comp = n2t::Code::compMnemonic((instruction >> compShift) & compMask);
+        const auto jump = n2t::Code::jumpMnemonic(instruction & jumpMask);
+        return fmt::format("{}{}{}{}{}", dest, dest.empty() ? "" : "=", comp, jump.empty() ? "" : ";", jump);
+    }
+    catch (const std::exception&)
+    {
+        return fmt::format("{:016b}", instruction);
+    }
+}
+}  // namespace
+
+n2t::CppTranslator::CppTranslator(std::filesystem::path inputFilename,
+                                  std::filesystem::path outputFilename,
+                                  std::filesystem::path symbolMapFilename) :
+    m_inputFilename{std::move(inputFilename)},
+    m_outputFilename{std::move(outputFilename)},
+    m_symbolMapFilename{std::move(symbolMapFilename)}
+{
+}
+
+n2t::CppTranslator::~CppTranslator() noexcept
+{
+    try
+    {
+        if (!m_translated)
+        {
+            std::filesystem::remove(m_outputFilename);
+        }
+    }
+    catch (...)
+    {
+    }
+}
+
+void n2t::CppTranslator::translate()
+{
+    throwUnless(!m_translated, "Input file ({}) has already been translated", m_inputFilename.filename().string());
+
+    m_rom = loadRomImage(m_inputFilename);
+    throwUnless(m_rom.size() <= romSize,
+                "Program size ({}) exceeds the instruction memory size ({})",
+                m_rom.size(),
+                romSize);
+
+    m_labels.assign(m_rom.size() + 1, {});
+    if (!m_symbolMapFilename.empty())
+    {
+        for (const auto& entry : loadSymbolMap(m_symbolMapFilename))
+        {
+            if ((entry.kind == SymbolKind::Label) && (entry.address <= m_rom.size()))
+            {
+                auto& label = m_labels[entry.address];
+                label.append(label.empty() ? "  // " : ", ").append(entry.symbol);
+            }
+        }
+    }
+
+    findBlocks();
+
+    std::string blocks;
+    bool        computedJumps = false;
+    for (std::size_t address = 0; address < m_rom.size();)
+    {
+        auto end = address + 1;
+        while (!m_blocks[end])
+        {
+            ++end;
+        }
+
+        fmt::format_to(std::back_inserter(blocks),
+                       "\n[[maybe_unused]] L{0}:{1}\n"
+                       "    if ((maxCycles - cycles) < {2})\n"
+                       "    {{\n"
+                       "        pc = {0};\n"
+                       "        goto stop;\n"
+                       "    }}\n"
+                       "    cycles += {2};\n",
+                       address,
+                       m_labels[address],
+                       end - address);
+
+        for (auto instruction = address; instruction < end; ++instruction)
+        {
+            computedJumps = writeInstruction(blocks, instruction, address) || computedJumps;
+        }
+        address = end;
+    }
+
+    std::string code;
+    auto        out = std::back_inserter(code);
+    fmt::format_to(out, "// Generated from {} by HackTranslator.\n", m_inputFilename.filename().string());
+    code.append(runtime);
+
+    // the instructions are also kept in a table for the computed jumps into the middle of a block
+    if (computedJumps)
+    {
+        code.append("\nnamespace\n{\nconstexpr uint16_t rom[] = {");
+        for (std::size_t address = 0; address < m_rom.size(); ++address)
+        {
+            fmt::format_to(out, "{}{:#06x},", ((address % 8) == 0) ? "\n    " : " ", m_rom[address]);
+        }
+        code.append("\n};\n}  // namespace\n");
+    }
+    code.append(mainPrologue);
+
+    // computed jumps go through a switch over the addresses of all blocks
+    if (computedJumps)
+    {
+        code.append("\ndispatch:\n    switch (pc)\n    {\n");
+        for (std::size_t address = 0; address < m_rom.size(); ++address)
+        {
+            if (m_blocks[address])
+            {
+                fmt::format_to(out, "        case {0}:\n            goto L{0};\n", address);
+            }
+        }
+        fmt::format_to(out,
+                       "        default:\n"
+                       "            break;\n"
+                       "    }}\n"
+                       "    if (pc >= {0})\n"
+                       "    {{\n"
+                       "        goto L{0};\n"
+                       "    }}\n"
+                       "\n"
+                       "    // a jump into the middle of a block runs one instruction at a time until a block starts\n"
+                       "    if (cycles == maxCycles)\n"
+                       "    {{\n"
+                       "        goto stop;\n"
+                       "    }}\n"
+                       "    ++cycles;\n"
+                       "    pc = execute(rom[pc], a, d, pc);\n"
+                       "    goto dispatch;\n",
+                       m_rom.size());
+    }
+    code.append(blocks);
+
+    fmt::format_to(out,
+                   "\n[[maybe_unused]] L{0}:{1}\n"
+                   "    halted = true;\n",
+                   m_rom.size(),
+                   m_labels[m_rom.size()]);
+    code.append(epilogue);
+
+    std::ofstream file{m_outputFilename, std::ios::binary};
+    throwUnless<std::runtime_error>(file.good(), "Could not open output file ({})", m_outputFilename.string());
+    file.write(code.data(), static_cast<std::streamsize>(code.size()));
+    throwUnless<std::runtime_error>(file.good(), "Could not write output file ({})", m_outputFilename.string());
+
+    m_translated = true;
+}
+
+void n2t::CppTranslator::findBlocks()
+{
+    const auto size = m_rom.size();
+
+    m_blocks.assign(size + 1, false);
+    m_blocks[0]    = true;
+    m_blocks[size] = true;
+
+    for (std::size_t address = 0; address < size; ++address)
+    {
+        const auto instruction = m_rom[address];
+        if ((instruction & cInstructionBit) == 0)
+        {
+            if (instruction < size)
+            {
+                m_blocks[instruction] = true;
+            }
+        }
+        else if ((instruction & jumpMask) != 0)
+        {
+            m_blocks[address + 1] = true;
+        }
+
+        if (!m_labels[address].empty())
+        {
+            m_blocks[address] = true;
+        }
+    }
+}
+
+bool n2t::CppTranslator::writeInstruction(std::string& code, std::size_t address, std::size_t blockAddress) const
+{
+    auto       out         = std::back_inserter(code);
+    const auto instruction = m_rom[address];
+
+    if ((instruction & cInstructionBit) == 0)
+    {
+        fmt::format_to(out, "    a = {};\n", instruction);
+        return false;
+    }
+
+    const auto comp = (instruction >> compShift) & compMask;
+    const auto jump = instruction & jumpMask;
+
+    // the target of a jump is known if the A register was loaded by the preceding instruction of the block
+    const auto previous    = (address > blockAddress) ? m_rom[address - 1] : cInstructionBit;
+    const auto knownTarget = (previous & cInstructionBit) == 0;
+
+    std::string action;
+    if ((jump != 0) && knownTarget && (previous == (address - 1)) && ((instruction & destMask) == 0))
+    {
+        // an infinite loop which changes no state
+        action = fmt::format("pc = {}; halted = true; goto stop;", previous);
+    }
+    else if ((jump != 0) && knownTarget)
+    {
+        action = fmt::format("goto L{};", std::min<std::size_t>(previous, m_rom.size()));
+    }
+    else if (jump != 0)
+    {
+        action = "pc = target; goto dispatch;";
+    }
+
+    if ((instruction & (destMask | jumpMask)) == 0)
+    {
+        // the instruction has no effect
+        fmt::format_to(out, "    // {}\n", mnemonic(instruction));
+        return false;
+    }
+
+    fmt::format_to(out, "    {{  // {}\n", mnemonic(instruction));
+    if (((instruction & destMask) != 0) || (jump != jumpAlways))
+    {
+        fmt::format_to(out, "        const uint16_t out = alu<{:#09b}>(d, a, ram[a & addressMask]);\n", comp);
+    }
+    if ((instruction & destM) != 0)
+    {
+        code.append("        ram[a & addressMask] = out;\n");
+    }
+    if ((instruction & destD) != 0)
+    {
+        code.append("        d = out;\n");
+    }
+    if ((jump != 0) && !knownTarget)
+    {
+        code.append("        const uint16_t target = a & addressMask;\n");
+    }
+    if ((instruction & destA) != 0)
+    {
+        code.append("        a = out;\n");
+    }
+
+    if (jump == jumpAlways)
+    {
+        fmt::format_to(out, "        {}\n", action);
+    }
+    else if (jump != 0)
+    {
+        fmt::format_to(out, "        if ({}) {{ {} }}\n", jumpConditions[jump], action);
+    }
+    code.append("    }\n");
+
+    return (jump != 0) && !knownTarget;
+}
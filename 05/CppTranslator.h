@@ -0,0 +1,81 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef N2T_CPP_TRANSLATOR_H
+#define N2T_CPP_TRANSLATOR_H
+
+#include <RomImage.h>
+#include <SymbolMap.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace n2t
+{
+// Translates a Hack program into a C++ program that runs it natively. Each basic block of the program becomes a
+// labeled region of the main function, which counts the cycles of the whole block when it is entered. Jumps to
+// constant addresses go directly to their block, while computed jumps, such as function returns, dispatch through
+// a switch statement over the addresses of all blocks, which the C++ compiler turns into a jump table. A computed
+// jump to any other address, such as an entry of a jump table that is not loaded by an A-instruction, executes the
+// instructions one at a time from a table of the program until it reaches the start of a block.
+class CppTranslator
+{
+public:
+    // The optional symbol map names the blocks that start at a label.
+    CppTranslator(std::filesystem::path inputFilename,
+                  std::filesystem::path outputFilename,
+                  std::filesystem::path symbolMapFilename = {});
+
+    CppTranslator(const CppTranslator&) = delete;
+    CppTranslator(CppTranslator&&)      = delete;
+
+    CppTranslator& operator=(const CppTranslator&) = delete;
+    CppTranslator& operator=(CppTranslator&&) = delete;
+
+    ~CppTranslator() noexcept;
+
+    void translate();
+
+private:
+    // Marks the first instruction of each basic block: the first instruction of the program, every instruction
+    // following a jump, every label and every address loaded by an A-instruction, which are the likely jump targets.
+    // The end of the program is also marked, as the program halts when it is reached.
+    void findBlocks();
+
+    // Returns whether the instruction jumps to an address computed at run time.
+    [[nodiscard]] bool writeInstruction(std::string& code, std::size_t address, std::size_t blockAddress) const;
+
+    std::filesystem::path    m_inputFilename;
+    std::filesystem::path    m_outputFilename;
+    std::filesystem::path    m_symbolMapFilename;
+    RomImage                 m_rom;
+    std::vector<bool>        m_blocks;
+    std::vector<std::string> m_labels;
+    bool                     m_translated = false;
+};
+}  // namespace n2t
+
+#endif
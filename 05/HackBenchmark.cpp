@@ -0,0 +1,230 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "HackComputer.h"
+
+#include <AssemblyEngine.h>
+#include <MappedFile.h>
+#include <RomImage.h>
+#include <Util.h>
+
+#include <cxxopts.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// operands of Mult.asm, chosen so that each product runs for about 300000 instructions
+constexpr uint16_t multiplicand = 7;
+constexpr uint16_t multiplier   = 30000;
+constexpr uint16_t product      = static_cast<uint16_t>(multiplicand * multiplier);
+
+struct Engine
+{
+    std::string_view     name;
+    n2t::ExecutionEngine engine;
+};
+
+// The naive engine is the baseline of the others.
+constexpr std::array engines{Engine{"naive", n2t::ExecutionEngine::Naive},
+                             Engine{"predecoded", n2t::ExecutionEngine::Predecoded},
+                             Engine{"super", n2t::ExecutionEngine::Superinstructions}};
+
+// Returns the shortest time of 'repetitions' runs of 'run', in seconds.
+[[nodiscard]] double measure(unsigned int repetitions, const std::function<void()>& run)
+{
+    auto best = std::numeric_limits<double>::max();
+    for (unsigned int repetition = 0; repetition < repetitions; ++repetition)
+    {
+        const auto startTime = std::chrono::steady_clock::now();
+        run();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+    }
+    return best;
+}
+
+// Loads a program, assembling it first if it is an assembly file.
+[[nodiscard]] n2t::RomImage loadProgram(const std::filesystem::path& filename)
+{
+    if (filename.extension() == ".asm")
+    {
+        const n2t::MappedFile file{filename};
+        return n2t::AssemblyEngine::assembleText(file.contents(), filename.filename().string());
+    }
+    return n2t::loadRomImage(filename);
+}
+
+// Multiplies the operands with Mult.asm over and over until 'cycles' instructions have been executed, and returns the
+// number of executed instructions.
+uint64_t runMult(n2t::HackComputer& computer, uint64_t cycles)
+{
+    uint64_t executed = 0;
+    while (executed < cycles)
+    {
+        computer.reset();
+        computer.ram()[0] = multiplicand;
+        computer.ram()[1] = multiplier;
+        executed += computer.run(cycles - executed);
+        n2t::throwUnless<std::runtime_error>(computer.halted() || (executed == cycles),
+                                             "Mult.asm did not halt after {} instructions",
+                                             computer.cycles());
+        n2t::throwUnless<std::runtime_error>(!computer.halted() || (computer.ram()[2] == product),
+                                             "Mult.asm computed a wrong product ({})",
+                                             computer.ram()[2]);
+    }
+    return executed;
+}
+
+// Runs the program once from reset for at most 'cycles' instructions, and returns the number of executed instructions.
+uint64_t runOnce(n2t::HackComputer& computer, uint64_t cycles)
+{
+    computer.reset();
+    return computer.run(cycles);
+}
+
+// Runs 'program' for at most 'cycles' instructions with each engine and prints the times. Each engine must leave the
+// same data memory as the naive engine.
+void benchmark(std::string_view                                          title,
+               const n2t::RomImage&                                      program,
+               uint64_t                                                  cycles,
+               unsigned int                                              repetitions,
+               const std::function<uint64_t(n2t::HackComputer&, uint64_t)>& run)
+{
+    std::cout << fmt::format("{}: {} instructions, {} cycles, fastest of {} runs\n",
+                             title,
+                             program.size(),
+                             cycles,
+                             repetitions);
+
+    double                baseTime = 0;
+    std::vector<uint16_t> baseRam;
+    for (const auto& [name, engine] : engines)
+    {
+        n2t::HackComputer computer{program, engine};
+
+        uint64_t   executed = 0;
+        const auto time     = measure(repetitions, [&] { executed = run(computer, cycles); });
+        const auto mips     = (time > 0) ? (static_cast<double>(executed) / time / 1e6) : 0.0;
+
+        if (baseRam.empty())
+        {
+            baseTime = time;
+            baseRam.assign(computer.ram().begin(), computer.ram().end());
+            std::cout << fmt::format("  {:<10}  {:8.1f} ms  {:7.1f} MIPS\n", name, time * 1e3, mips);
+        }
+        else
+        {
+            std::cout << fmt::format("  {:<10}  {:8.1f} ms  {:7.1f} MIPS  ({:.1f}x)\n",
+                                     name,
+                                     time * 1e3,
+                                     mips,
+                                     (time > 0) ? (baseTime / time) : 0.0);
+            n2t::throwUnless<std::runtime_error>(std::ranges::equal(computer.ram(), baseRam),
+                                                 "The {} engine left a different data memory than the naive engine",
+                                                 name);
+        }
+    }
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    int result = EXIT_SUCCESS;
+
+    const std::filesystem::path programPath{*argv};
+    cxxopts::Options            options{programPath.filename(), "Hack Execution Engine Benchmark"};
+
+    try
+    {
+        /*
+         * Parse command line options
+         */
+
+        uint64_t              cycles      = 0;
+        unsigned int          repetitions = 0;
+        std::filesystem::path multPath;
+        std::filesystem::path jackPath;
+
+        // clang-format off
+        options.add_options()
+            ("help", "Display this help message")
+            ("c,cycles", "Number of instructions executed in each run", cxxopts::value<uint64_t>(cycles)->default_value("30000000"))
+            ("j,jack", "Compiled Jack program (.asm or .hack), which is run from reset for the given cycles", cxxopts::value<std::filesystem::path>(jackPath))
+            ("m,mult", "Mult.asm program of project 4", cxxopts::value<std::filesystem::path>(multPath)->default_value(N2T_MULT_ASM))
+            ("r,repetitions", "Number of runs of each engine, of which the fastest is reported", cxxopts::value<unsigned int>(repetitions)->default_value("5"));
+        // clang-format on
+
+        const auto optionsMap = options.parse(argc, argv);
+
+        if (optionsMap.count("help") != 0)
+        {
+            std::cout << options.help() << '\n';
+            return EXIT_SUCCESS;
+        }
+
+        if (repetitions == 0)
+        {
+            throw cxxopts::OptionParseException{"Option 'repetitions' must be positive"};
+        }
+
+        /*
+         * Run benchmark
+         */
+
+        benchmark(multPath.filename().string(), loadProgram(multPath), cycles, repetitions, runMult);
+
+        if (!jackPath.empty())
+        {
+            benchmark(jackPath.filename().string(), loadProgram(jackPath), cycles, repetitions, runOnce);
+        }
+    }
+    catch (const cxxopts::OptionException& ex)
+    {
+        result = EXIT_FAILURE;
+        std::cerr << "ERROR: " << ex.what() << "\n\n";
+        std::cout << options.help() << '\n';
+    }
+    catch (const std::exception& ex)
+    {
+        result = EXIT_FAILURE;
+        std::cerr << "ERROR: " << ex.what() << '\n';
+    }
+
+    return result;
+}
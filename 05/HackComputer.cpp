@@ -0,0 +1,756 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "HackComputer.h"
+
+#include "Alu.h"
+
+#include <Util.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace
+{
+constexpr uint16_t cInstructionBit = 0x8000;
+constexpr uint16_t addressMask     = 0x7FFF;
+constexpr uint16_t compShift       = 6;
+constexpr uint16_t compMask        = 0x7F;
+constexpr uint16_t destA           = 0b100000;
+constexpr uint16_t destD           = 0b010000;
+constexpr uint16_t destM           = 0b001000;
+constexpr uint16_t destMask        = 0b111000;
+constexpr uint16_t destShift       = 3;
+constexpr uint16_t jumpMask        = 0b000111;
+constexpr uint16_t jumpAlways      = 0b111;
+constexpr uint16_t numJumps        = 8;
+
+// Handler indices of the predecoded operations. The handlers of the C-instructions are specialized for each 'dest'
+// and 'jump' field, and follow the other handlers.
+constexpr uint16_t haltHandler     = 0;
+constexpr uint16_t loadAHandler    = 1;
+constexpr uint16_t idleLoopHandler = 2;
+constexpr uint16_t firstCHandler   = 3;
+
+// Handler indices of the superinstructions, which follow the C-instruction handlers.
+constexpr uint16_t pushDHandler        = firstCHandler + 64;
+constexpr uint16_t popDHandler         = pushDHandler + 1;
+constexpr uint16_t stackTopHandler     = pushDHandler + 2;
+constexpr uint16_t loadConstantHandler = pushDHandler + 3;
+constexpr uint16_t loadDHandler        = pushDHandler + 4;
+constexpr uint16_t storeDHandler       = pushDHandler + 5;
+constexpr uint16_t jumpHandler         = pushDHandler + 6;
+constexpr uint16_t jumpIfDHandler      = pushDHandler + 7;
+
+// Handler index of a breakpoint, which temporarily replaces an operation.
+constexpr uint16_t breakpointHandler = pushDHandler + 8;
+
+// Instruction sequence fused into a superinstruction. The sequence starts with an A-instruction, which loads either
+// the stack pointer or any value, followed by C-instructions.
+struct Superinstruction
+{
+    uint16_t                handler       = 0;
+    bool                    anyValue      = false;
+    std::size_t             length        = 0;
+    std::array<uint16_t, 3> cInstructions = {};
+};
+
+// The sequences generated by the VM translator for stack operations, constants, variables and jumps.
+// clang-format off
+constexpr std::array<Superinstruction, 8> superinstructions =
+{{
+    {pushDHandler,        false, 4, {0xFDE8, 0xECA0, 0xE308}},  // @SP, AM=M+1, A=A-1, M=D
+    {popDHandler,         false, 3, {0xFCA8, 0xFC10}},          // @SP, AM=M-1, D=M
+    {stackTopHandler,     false, 2, {0xFCA0}},                  // @SP, A=M-1
+    {loadConstantHandler, true,  2, {0xEC10}},                  // @X, D=A
+    {loadDHandler,        true,  2, {0xFC10}},                  // @X, D=M
+    {storeDHandler,       true,  2, {0xE308}},                  // @X, M=D
+    {jumpHandler,         true,  2, {0xEA87}},                  // @X, 0;JMP
+    {jumpIfDHandler,      true,  2, {0xE305}}                   // @X, D;JNE
+}};
+// clang-format on
+
+[[nodiscard]] constexpr uint16_t bitMask(uint16_t bits) noexcept
+{
+    return (bits != 0) ? uint16_t{0xFFFF} : uint16_t{0};
+}
+
+template<typename Operation>
+[[nodiscard]] inline uint16_t compute(const Operation& operation, uint16_t d, uint16_t a, uint16_t m) noexcept
+{
+    const auto x = static_cast<uint16_t>((d & operation.keepX) ^ operation.flipX);
+    const auto y = static_cast<uint16_t>((((m & operation.selectM) | (a & ~operation.selectM)) & operation.keepY) ^
+                                         operation.flipY);
+    const auto sum = static_cast<uint16_t>(x + y);
+    return static_cast<uint16_t>(((sum & operation.add) | (x & y & ~operation.add)) ^ operation.flipOut);
+}
+
+// Marks a written word of the data memory as changed if it belongs to the screen memory map.
+inline void markScreenChange(uint64_t* screenChanges, uint16_t address) noexcept
+{
+    const auto offset = static_cast<uint16_t>(address - n2t::HackComputer::screenAddress);
+    if (offset < n2t::HackComputer::screenSize)
+    {
+        screenChanges[offset / 64] |= uint64_t{1} << (offset % 64);
+    }
+}
+
+// Executes a C-instruction and returns the address of the next instruction.
+template<uint16_t Dest, uint16_t Jump, typename Operation>
+[[nodiscard]] inline uint16_t execute(const Operation& operation,
+                                      uint16_t&        a,
+                                      uint16_t&        d,
+                                      uint16_t         pc,
+                                      uint16_t*        ram,
+                                      uint64_t*        screenChanges) noexcept
+{
+    const auto address = static_cast<uint16_t>(a & addressMask);
+    const auto out     = compute(operation, d, a, ram[address]);
+
+    if constexpr (((Dest << destShift) & destM) != 0)
+    {
+        ram[address] = out;
+        markScreenChange(screenChanges, address);
+    }
+    if constexpr (((Dest << destShift) & destD) != 0)
+    {
+        d = out;
+    }
+    if constexpr (((Dest << destShift) & destA) != 0)
+    {
+        a = out;
+    }
+
+    if constexpr (Jump == 0)
+    {
+        return static_cast<uint16_t>(pc + 1);
+    }
+    else if constexpr (Jump == jumpAlways)
+    {
+        return address;
+    }
+    else
+    {
+        return n2t::jumps(Jump, out) ? address : static_cast<uint16_t>(pc + 1);
+    }
+}
+}  // namespace
+
+// Computed goto is a GNU extension, also supported by Clang. Other compilers dispatch through a switch statement.
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(N2T_NO_COMPUTED_GOTO)
+#define N2T_COMPUTED_GOTO 1
+#else
+#define N2T_COMPUTED_GOTO 0
+#endif
+
+// Lists the specialized C-instruction handlers as X(dest, jump).
+#define N2T_C_HANDLERS_FOR_DEST(X, dest) \
+    X(dest, 0) X(dest, 1) X(dest, 2) X(dest, 3) X(dest, 4) X(dest, 5) X(dest, 6) X(dest, 7)
+#define N2T_C_HANDLERS(X)                                                                             \
+    N2T_C_HANDLERS_FOR_DEST(X, 0) N2T_C_HANDLERS_FOR_DEST(X, 1) N2T_C_HANDLERS_FOR_DEST(X, 2)         \
+    N2T_C_HANDLERS_FOR_DEST(X, 3) N2T_C_HANDLERS_FOR_DEST(X, 4) N2T_C_HANDLERS_FOR_DEST(X, 5)         \
+    N2T_C_HANDLERS_FOR_DEST(X, 6) N2T_C_HANDLERS_FOR_DEST(X, 7)
+
+std::optional<n2t::ExecutionEngine> n2t::findExecutionEngine(std::string_view name)
+{
+    if (name == "naive")
+    {
+        return ExecutionEngine::Naive;
+    }
+    if (name == "predecoded")
+    {
+        return ExecutionEngine::Predecoded;
+    }
+    if (name == "super")
+    {
+        return ExecutionEngine::Superinstructions;
+    }
+    if (name == "jit")
+    {
+        return ExecutionEngine::Jit;
+    }
+    return std::nullopt;
+}
+
+n2t::HackComputer::HackComputer(RomImage rom, ExecutionEngine engine) :
+    m_rom{std::move(rom)}, m_engine{engine}, m_ram(ramSize), m_screenChanges(screenSize / 64, ~uint64_t{0})
+{
+    throwUnless(m_rom.size() <= romSize,
+                "Program size ({}) exceeds the instruction memory size ({})",
+                m_rom.size(),
+                romSize);
+
+    if ((m_engine == ExecutionEngine::Predecoded) || (m_engine == ExecutionEngine::Superinstructions))
+    {
+        predecode();
+    }
+    if (m_engine == ExecutionEngine::Superinstructions)
+    {
+        fuseSuperinstructions();
+    }
+    if (m_engine == ExecutionEngine::Jit)
+    {
+        m_jit = std::make_unique<JitCompiler>(m_rom);
+    }
+}
+
+void n2t::HackComputer::reset()
+{
+    std::fill(m_ram.begin(), m_ram.end(), uint16_t{0});
+    markScreenChanged();
+    m_cycles = 0;
+    m_a      = 0;
+    m_d      = 0;
+    m_pc     = 0;
+    m_halted = false;
+}
+
+void n2t::HackComputer::clearScreenChanges()
+{
+    std::fill(m_screenChanges.begin(), m_screenChanges.end(), uint64_t{0});
+}
+
+void n2t::HackComputer::markScreenChanged()
+{
+    std::fill(m_screenChanges.begin(), m_screenChanges.end(), ~uint64_t{0});
+}
+
+void n2t::HackComputer::attachProfiler(Profiler* profiler)
+{
+    m_profiler = profiler;
+    if (m_profiler != nullptr)
+    {
+        m_profiler->start(m_pc);
+    }
+}
+
+uint64_t n2t::HackComputer::run(uint64_t maxCycles)
+{
+    if (m_profiler != nullptr)
+    {
+        return runNaive(maxCycles, *m_profiler);
+    }
+
+    switch (m_engine)
+    {
+        case ExecutionEngine::Naive:
+            return runNaive(maxCycles);
+        case ExecutionEngine::Jit:
+            return runJit(maxCycles);
+        default:
+            return runPredecoded(maxCycles);
+    }
+}
+
+uint64_t n2t::HackComputer::runUntil(uint16_t address, uint64_t maxCycles)
+{
+    throwUnless(address < m_rom.size(),
+                "Address ({}) is outside of the program ({} instructions)",
+                address,
+                m_rom.size());
+
+    if (m_operations.empty() || (m_profiler != nullptr))
+    {
+        // the engines without predecoded operations step through the program
+        auto cycles = uint64_t{0};
+        while (!m_halted && (m_pc != address) && (cycles < maxCycles))
+        {
+            cycles += run(1);
+        }
+        return cycles;
+    }
+
+    if (m_pc == address)
+    {
+        return 0;
+    }
+
+    // the superinstructions spanning the breakpoint are replaced with their first instruction, and the operations
+    // are restored after the run
+    std::vector<std::pair<std::size_t, uint16_t>> saved;
+    for (std::size_t start = (address >= 3) ? (address - 3u) : 0; start < address; ++start)
+    {
+        auto&       operation        = m_operations[start];
+        const auto* superinstruction = std::find_if(
+            superinstructions.begin(), superinstructions.end(), [&](const Superinstruction& candidate) {
+                return candidate.handler == operation.handler;
+            });
+        if ((superinstruction != superinstructions.end()) && ((start + superinstruction->length) > address))
+        {
+            saved.emplace_back(start, operation.handler);
+            operation.handler = operation.baseHandler;
+        }
+    }
+    saved.emplace_back(address, m_operations[address].handler);
+    m_operations[address].handler = breakpointHandler;
+
+    const auto cycles = runPredecoded(maxCycles);
+
+    for (const auto& [index, handler] : saved)
+    {
+        m_operations[index].handler = handler;
+    }
+    return cycles;
+}
+
+void n2t::HackComputer::restore(uint16_t a, uint16_t d, uint16_t pc, uint64_t cycles, bool halted)
+{
+    markScreenChanged();
+    m_a      = a;
+    m_d      = d;
+    m_pc     = pc;
+    m_cycles = cycles;
+    m_halted = halted;
+}
+
+void n2t::HackComputer::predecode()
+{
+    m_operations.assign(romSize + 1, Operation{haltHandler});
+
+    for (std::size_t address = 0; address < m_rom.size(); ++address)
+    {
+        const auto instruction = m_rom[address];
+        auto&      operation   = m_operations[address];
+
+        if ((instruction & cInstructionBit) == 0)
+        {
+            operation.handler = loadAHandler;
+            operation.value   = instruction;
+            continue;
+        }
+
+        const auto comp = static_cast<uint16_t>((instruction >> compShift) & compMask);
+        operation.selectM = bitMask(comp & 0b1000000);
+        operation.keepX   = static_cast<uint16_t>(~bitMask(comp & 0b0100000));
+        operation.flipX   = bitMask(comp & 0b0010000);
+        operation.keepY   = static_cast<uint16_t>(~bitMask(comp & 0b0001000));
+        operation.flipY   = bitMask(comp & 0b0000100);
+        operation.add     = bitMask(comp & 0b0000010);
+        operation.flipOut = bitMask(comp & 0b0000001);
+
+        const auto dest = static_cast<uint16_t>((instruction & destMask) >> destShift);
+        const auto jump = static_cast<uint16_t>(instruction & jumpMask);
+
+        // a jump that may loop forever on the preceding '@target' without changing any state
+        if ((dest == 0) && (jump != 0) && (address != 0) && (m_rom[address - 1] == (address - 1)))
+        {
+            operation.handler = idleLoopHandler;
+            operation.value   = jump;
+        }
+        else
+        {
+            operation.handler = static_cast<uint16_t>(firstCHandler + (dest * numJumps) + jump);
+        }
+    }
+}
+
+void n2t::HackComputer::fuseSuperinstructions()
+{
+    for (std::size_t address = 0; address < m_rom.size(); ++address)
+    {
+        const auto instruction = m_rom[address];
+        if ((instruction & cInstructionBit) != 0)
+        {
+            continue;
+        }
+
+        const auto matches = [&](const Superinstruction& superinstruction) {
+            if ((!superinstruction.anyValue && (instruction != 0)) ||
+                ((address + superinstruction.length) > m_rom.size()))
+            {
+                return false;
+            }
+            for (std::size_t index = 1; index < superinstruction.length; ++index)
+            {
+                if (m_rom[address + index] != superinstruction.cInstructions[index - 1])
+                {
+                    return false;
+                }
+            }
+            // a jump to itself must be detected as a halt by its own handler
+            return m_operations[address + superinstruction.length - 1].handler != idleLoopHandler;
+        };
+
+        const auto* superinstruction = std::find_if(superinstructions.begin(), superinstructions.end(), matches);
+        if (superinstruction != superinstructions.end())
+        {
+            auto& operation       = m_operations[address];
+            operation.baseHandler = operation.handler;
+            operation.handler     = superinstruction->handler;
+        }
+    }
+}
+
+uint64_t n2t::HackComputer::runNaive(uint64_t maxCycles)
+{
+    NoProfiler profiler;
+    return runNaive(maxCycles, profiler);
+}
+
+template<typename ProfilerPolicy>
+uint64_t n2t::HackComputer::runNaive(uint64_t maxCycles, ProfilerPolicy& profiler)
+{
+    // keep the registers in local variables, which the compiler can keep in host registers
+    const auto* rom     = m_rom.data();
+    const auto  romSize = m_rom.size();
+    auto*       ram     = m_ram.data();
+    auto*       changes = m_screenChanges.data();
+    auto        a       = m_a;
+    auto        d       = m_d;
+    auto        pc      = m_pc;
+    auto        halted  = m_halted;
+
+    uint64_t cycles = 0;
+    for (; !halted && (cycles < maxCycles); ++cycles)
+    {
+        if (pc >= romSize)
+        {
+            halted = true;
+            break;
+        }
+
+        profiler.count(pc);
+
+        const auto instruction = rom[pc];
+        if ((instruction & cInstructionBit) == 0)
+        {
+            a = instruction;
+            ++pc;
+            continue;
+        }
+
+        const auto address = static_cast<uint16_t>(a & addressMask);
+        const auto out     = aluTable[(instruction >> compShift) & compMask](d, a, ram[address]);
+
+        if ((instruction & destM) != 0)
+        {
+            ram[address] = out;
+            markScreenChange(changes, address);
+        }
+        if ((instruction & destD) != 0)
+        {
+            d = out;
+        }
+        const auto target = a;
+        if ((instruction & destA) != 0)
+        {
+            a = out;
+        }
+
+        if (jumps(instruction & jumpMask, out))
+        {
+            // a jump to the preceding '@target' which changes no state loops forever
+            halted = (pc != 0) && (target == static_cast<uint16_t>(pc - 1)) && ((instruction & destMask) == 0) &&
+                     (rom[target] == target);
+            pc     = static_cast<uint16_t>(target & addressMask);
+            profiler.jump(pc, ram);
+        }
+        else
+        {
+            ++pc;
+        }
+    }
+
+    m_a      = a;
+    m_d      = d;
+    m_pc     = pc;
+    m_halted = halted;
+    m_cycles += cycles;
+
+    return cycles;
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"  // labels as values
+
+uint64_t n2t::HackComputer::runPredecoded(uint64_t maxCycles)
+{
+    if (m_halted)
+    {
+        return 0;
+    }
+
+    const auto* operations = m_operations.data();
+    auto*       ram        = m_ram.data();
+    auto*       changes    = m_screenChanges.data();
+    auto        a          = m_a;
+    auto        d          = m_d;
+    auto        pc         = m_pc;
+    auto        halted     = false;
+    auto        remaining  = maxCycles;
+
+#if N2T_COMPUTED_GOTO
+#define N2T_C_LABEL(dest, jump) &&execute_##dest##_##jump,
+    static const void* const handlers[] = {&&halt,
+                                           &&loadA,
+                                           &&idleLoop,
+                                           N2T_C_HANDLERS(N2T_C_LABEL) &&pushD,
+                                           &&popD,
+                                           &&stackTop,
+                                           &&loadConstant,
+                                           &&loadD,
+                                           &&storeD,
+                                           &&jump,
+                                           &&jumpIfD,
+                                           &&breakpoint};
+#undef N2T_C_LABEL
+
+#define N2T_HANDLER(label, index) label:
+#define N2T_DISPATCH()                            \
+    if (remaining == 0)                           \
+    {                                             \
+        goto stop;                                \
+    }                                             \
+    --remaining;                                  \
+    goto* handlers[operations[pc].handler]
+
+#define N2T_BASE_DISPATCH() goto* handlers[operations[pc].baseHandler]
+
+    N2T_DISPATCH();
+#else
+#define N2T_HANDLER(label, index) case index:
+#define N2T_DISPATCH() continue
+#define N2T_BASE_DISPATCH()                  \
+    handler = operations[pc].baseHandler;    \
+    goto dispatch
+
+    uint16_t handler = 0;
+    for (;;)
+    {
+        if (remaining == 0)
+        {
+            goto stop;
+        }
+        --remaining;
+
+        handler = operations[pc].handler;
+    dispatch:
+        switch (handler)
+        {
+#endif
+
+// A superinstruction of 'length' instructions is executed only if enough cycles remain, otherwise its first
+// instruction is executed by its base handler. One cycle has already been counted by the dispatch.
+#define N2T_SUPERINSTRUCTION(length)    \
+    if (remaining < ((length)-1))       \
+    {                                   \
+        N2T_BASE_DISPATCH();            \
+    }                                   \
+    remaining -= (length)-1
+
+    N2T_HANDLER(halt, haltHandler)
+    {
+        // reaching the end of the program does not execute an instruction
+        ++remaining;
+        halted = true;
+        goto stop;
+    }
+
+    N2T_HANDLER(loadA, loadAHandler)
+    {
+        a = operations[pc].value;
+        ++pc;
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(idleLoop, idleLoopHandler)
+    {
+        const auto& operation = operations[pc];
+        const auto  address   = static_cast<uint16_t>(a & addressMask);
+        if (jumps(operation.value, compute(operation, d, a, ram[address])))
+        {
+            halted = (a == static_cast<uint16_t>(pc - 1));
+            pc     = address;
+            if (halted)
+            {
+                goto stop;
+            }
+        }
+        else
+        {
+            ++pc;
+        }
+        N2T_DISPATCH();
+    }
+
+#define N2T_C_HANDLER(dest, jump)                                                     \
+    N2T_HANDLER(execute_##dest##_##jump, firstCHandler + ((dest)*numJumps) + (jump))  \
+    {                                                                                 \
+        pc = execute<(dest), (jump)>(operations[pc], a, d, pc, ram, changes);         \
+        N2T_DISPATCH();                                                               \
+    }
+    N2T_C_HANDLERS(N2T_C_HANDLER)
+#undef N2T_C_HANDLER
+
+    N2T_HANDLER(pushD, pushDHandler)
+    {
+        N2T_SUPERINSTRUCTION(4);
+        const auto sp = ram[0];
+        ram[0]        = static_cast<uint16_t>(sp + 1);
+        a             = sp;
+        ram[a & addressMask] = d;
+        markScreenChange(changes, a & addressMask);
+        pc += 4;
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(popD, popDHandler)
+    {
+        N2T_SUPERINSTRUCTION(3);
+        a      = static_cast<uint16_t>(ram[0] - 1);
+        ram[0] = a;
+        d      = ram[a & addressMask];
+        pc += 3;
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(stackTop, stackTopHandler)
+    {
+        N2T_SUPERINSTRUCTION(2);
+        a = static_cast<uint16_t>(ram[0] - 1);
+        pc += 2;
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(loadConstant, loadConstantHandler)
+    {
+        N2T_SUPERINSTRUCTION(2);
+        a = operations[pc].value;
+        d = a;
+        pc += 2;
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(loadD, loadDHandler)
+    {
+        N2T_SUPERINSTRUCTION(2);
+        a = operations[pc].value;
+        d = ram[a];
+        pc += 2;
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(storeD, storeDHandler)
+    {
+        N2T_SUPERINSTRUCTION(2);
+        a      = operations[pc].value;
+        ram[a] = d;
+        markScreenChange(changes, a);
+        pc += 2;
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(jump, jumpHandler)
+    {
+        N2T_SUPERINSTRUCTION(2);
+        a  = operations[pc].value;
+        pc = a;
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(jumpIfD, jumpIfDHandler)
+    {
+        N2T_SUPERINSTRUCTION(2);
+        a  = operations[pc].value;
+        pc = (d != 0) ? a : static_cast<uint16_t>(pc + 2);
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(breakpoint, breakpointHandler)
+    {
+        // reaching a breakpoint does not execute an instruction
+        ++remaining;
+        goto stop;
+    }
+
+#if !N2T_COMPUTED_GOTO
+            default:
+                throwAlways("Invalid operation handler ({})", operations[pc].handler);
+        }
+    }
+#endif
+
+#undef N2T_HANDLER
+#undef N2T_DISPATCH
+#undef N2T_BASE_DISPATCH
+#undef N2T_SUPERINSTRUCTION
+
+stop:
+    const auto cycles = maxCycles - remaining;
+
+    m_a      = a;
+    m_d      = d;
+    m_pc     = pc;
+    m_halted = halted;
+    m_cycles += cycles;
+
+    return cycles;
+}
+
+#pragma GCC diagnostic pop
+
+uint64_t n2t::HackComputer::runJit(uint64_t maxCycles)
+{
+    JitState state;
+    state.ram           = m_ram.data();
+    state.screenChanges = m_screenChanges.data();
+
+    auto remaining = maxCycles;
+    auto entry     = true;  // whether the PC has been reached by a jump, which may start a block worth compiling
+    while (!m_halted && (remaining != 0))
+    {
+        const auto* code = (m_pc < m_rom.size()) ? m_jit->find(m_pc, entry) : nullptr;
+        if (code != nullptr)
+        {
+            state.remaining = remaining;
+            state.a         = m_a;
+            state.d         = m_d;
+            state.pc        = m_pc;
+            m_jit->execute(code, state);
+
+            // the block is not executed if the remaining cycles do not cover it
+            const auto cycles = remaining - state.remaining;
+            if (cycles != 0)
+            {
+                m_a      = state.a;
+                m_d      = state.d;
+                m_pc     = state.pc;
+                m_halted = state.halted;
+                m_cycles += cycles;
+
+                remaining = state.remaining;
+                entry     = true;
+                continue;
+            }
+        }
+
+        const auto pc = m_pc;
+        remaining -= runNaive(1);
+        entry = (m_pc != static_cast<uint16_t>(pc + 1));
+    }
+
+    return maxCycles - remaining;
+}
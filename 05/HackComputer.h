@@ -0,0 +1,219 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef N2T_HACK_COMPUTER_H
+#define N2T_HACK_COMPUTER_H
+
+#include "JitCompiler.h"
+#include "Profiler.h"
+
+#include <RomImage.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace n2t
+{
+enum class ExecutionEngine
+{
+    Naive,       // decodes every instruction when it is executed
+    Predecoded,  // decodes the program once, and dispatches to a handler specialized for each instruction form
+    Superinstructions,  // predecoded, with common instruction sequences fused into single operations
+    Jit,                // compiles the frequently executed basic blocks to native code, on x86-64 Linux only
+};
+
+// Returns the execution engine of the given command line name (naive, predecoded, super, jit), if any.
+[[nodiscard]] std::optional<ExecutionEngine> findExecutionEngine(std::string_view name);
+
+// Emulates the Hack computer: the CPU, the instruction memory (ROM) and the data memory (RAM), which includes the
+// memory maps of the screen and the keyboard.
+class HackComputer
+{
+public:
+    static constexpr std::size_t ramSize         = 0x8000;
+    static constexpr uint16_t    screenAddress   = 0x4000;
+    static constexpr uint16_t    keyboardAddress = 0x6000;
+    static constexpr uint16_t    screenSize      = keyboardAddress - screenAddress;
+
+    // Loads the program into the instruction memory and resets the computer.
+    explicit HackComputer(RomImage rom, ExecutionEngine engine = ExecutionEngine::Superinstructions);
+
+    HackComputer(const HackComputer&) = delete;
+    HackComputer(HackComputer&&)      = default;
+
+    HackComputer& operator=(const HackComputer&) = delete;
+    HackComputer& operator=(HackComputer&&) = default;
+
+    ~HackComputer() = default;
+
+    // Clears the registers and the data memory, and restarts the program from its first instruction.
+    void reset();
+
+    // Executes instructions until the program halts or 'maxCycles' instructions have been executed, and returns the
+    // number of executed instructions. The program halts when the PC leaves the program, or when it enters an
+    // infinite loop that changes no state, such as '(END) @END 0;JMP'.
+    uint64_t run(uint64_t maxCycles);
+
+    // Executes instructions like run(), but stops before executing the instruction at 'address'. The predecoded
+    // engines stop on a breakpoint that temporarily replaces the operation at 'address', and the other engines
+    // execute one instruction at a time. The address must be inside the program.
+    uint64_t runUntil(uint16_t address, uint64_t maxCycles);
+
+    // Sets the registers and the cycle count, for example to restore a snapshot together with the data memory, and
+    // marks the whole screen as changed.
+    void restore(uint16_t a, uint16_t d, uint16_t pc, uint64_t cycles, bool halted);
+
+    // Counts the instructions of the following runs in 'profiler', which then use the naive engine, or stops
+    // profiling if 'profiler' is nullptr. The profiler call stack starts at the current PC.
+    void attachProfiler(Profiler* profiler);
+
+    // Advances the cycle count without executing instructions, for a program known to be in a loop whose period
+    // divides 'cycles', and which therefore ends in the same state.
+    void skipCycles(uint64_t cycles)
+    {
+        m_cycles += cycles;
+    }
+
+    [[nodiscard]] bool halted() const
+    {
+        return m_halted;
+    }
+
+    [[nodiscard]] uint64_t cycles() const
+    {
+        return m_cycles;
+    }
+
+    [[nodiscard]] uint16_t a() const
+    {
+        return m_a;
+    }
+
+    [[nodiscard]] uint16_t d() const
+    {
+        return m_d;
+    }
+
+    [[nodiscard]] uint16_t pc() const
+    {
+        return m_pc;
+    }
+
+    [[nodiscard]] std::span<const uint16_t> rom() const
+    {
+        return m_rom;
+    }
+
+    [[nodiscard]] std::span<const uint16_t> ram() const
+    {
+        return m_ram;
+    }
+
+    [[nodiscard]] std::span<uint16_t> ram()
+    {
+        return m_ram;
+    }
+
+    // Returns the words of the screen memory map written by the program since the changes were last cleared, as a
+    // bitmap with one bit per word. Writing a word marks it even if its value does not change.
+    [[nodiscard]] std::span<const uint64_t> screenChanges() const
+    {
+        return m_screenChanges;
+    }
+
+    void clearScreenChanges();
+
+    // Marks the whole screen as changed, for example after the data memory has been modified through ram().
+    void markScreenChanged();
+
+private:
+    // Instruction decoded into the index of its handler, and either the value of an A-instruction or the inputs of
+    // the ALU, expressed as masks so that the ALU output is computed without branches.
+    struct Operation
+    {
+        uint16_t handler     = 0;
+        uint16_t baseHandler = 0;  // handler of the first instruction fused into a superinstruction
+        uint16_t value       = 0;  // value of an A-instruction
+        uint16_t selectM     = 0;  // all ones if the 'y' input of the ALU is M, zero if it is A
+        uint16_t keepX       = 0;  // zero if the 'x' input is zeroed ('zx')
+        uint16_t flipX       = 0;  // all ones if the 'x' input is negated ('nx')
+        uint16_t keepY       = 0;  // zero if the 'y' input is zeroed ('zy')
+        uint16_t flipY       = 0;  // all ones if the 'y' input is negated ('ny')
+        uint16_t add         = 0;  // all ones if the output is 'x + y', zero if it is 'x & y' ('f')
+        uint16_t flipOut     = 0;  // all ones if the output is negated ('no')
+    };
+
+    // Decodes every instruction of the program. The entries following the program halt the computer, so that any
+    // jump target is a valid index.
+    void predecode();
+
+    // Replaces the first operation of each common instruction sequence with a superinstruction, which executes the
+    // whole sequence at once and leaves the same state as the sequence. Only the last instruction of a sequence may
+    // jump, so each sequence lies within a straight-line basic block. The other operations of the sequence are
+    // kept, so that a jump into the middle of a sequence executes the original instructions.
+    void fuseSuperinstructions();
+
+    // Policy of the naive engine that does not profile.
+    struct NoProfiler
+    {
+        void count(uint16_t /*pc*/)
+        {
+        }
+
+        void jump(uint16_t /*target*/, const uint16_t* /*ram*/)
+        {
+        }
+    };
+
+    // The profiler policy is a template parameter, so that the engine does not test whether it profiles.
+    template<typename ProfilerPolicy>
+    uint64_t runNaive(uint64_t maxCycles, ProfilerPolicy& profiler);
+
+    uint64_t runNaive(uint64_t maxCycles);
+    uint64_t runPredecoded(uint64_t maxCycles);
+
+    // Runs the compiled blocks, and interprets the instructions which are not part of a compiled block.
+    uint64_t runJit(uint64_t maxCycles);
+
+    RomImage                     m_rom;
+    std::vector<Operation>       m_operations;
+    ExecutionEngine              m_engine;
+    std::unique_ptr<JitCompiler> m_jit;
+    Profiler*                    m_profiler = nullptr;
+    std::vector<uint16_t>        m_ram;
+    std::vector<uint64_t>        m_screenChanges;
+    uint64_t                     m_cycles = 0;
+    uint16_t                     m_a      = 0;
+    uint16_t                     m_d      = 0;
+    uint16_t                     m_pc     = 0;
+    bool                         m_halted = false;
+};
+}  // namespace n2t
+
+#endif
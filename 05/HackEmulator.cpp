@@ -0,0 +1,302 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "HackComputer.h"
+#include "KeyboardScript.h"
+#include "Profiler.h"
+#include "ScreenCapture.h"
+#include "Snapshot.h"
+
+#include <RamOptions.h>
+#include <RomImage.h>
+#include <SymbolMap.h>
+#include <Util.h>
+
+#include <cxxopts.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    int result = EXIT_SUCCESS;
+
+    const std::filesystem::path programPath{*argv};
+    cxxopts::Options            options{programPath.filename(), "Hack CPU Emulator"};
+
+    try
+    {
+        /*
+         * Parse command line options
+         */
+
+        uint64_t              maxCycles = std::numeric_limits<uint64_t>::max();
+        std::string           engineName;
+        bool                  quiet = false;
+        std::filesystem::path framesDirectory;
+        std::string           frameFormatName;
+        uint64_t              frameCycles = 0;
+        std::filesystem::path keyboardScript;
+        std::filesystem::path symbolMapFilename;
+        std::filesystem::path profileFilename;
+        std::filesystem::path saveSnapshotFilename;
+        std::string           snapshotLabel;
+        std::filesystem::path loadSnapshotFilename;
+
+        options.show_positional_help();
+
+        // clang-format off
+        options.add_options()
+            ("help", "Display this help message")
+            ("c,cycles", "Stop after 'arg' instructions", cxxopts::value<uint64_t>(maxCycles))
+            ("e,engine", "Execution engine (naive, predecoded, super, jit)", cxxopts::value<std::string>(engineName)->default_value("super"))
+            ("f,frames", "Write the frames of the screen into directory 'arg'", cxxopts::value<std::filesystem::path>(framesDirectory))
+            ("frame-cycles", "Capture a frame every 'arg' instructions", cxxopts::value<uint64_t>(frameCycles)->default_value("1000000"))
+            ("frame-format", "Frame format (pbm, raw)", cxxopts::value<std::string>(frameFormatName)->default_value("pbm"))
+            ("k,keyboard", "Keyboard script of '<cycle> <key>' and 'poll <key>' events", cxxopts::value<std::filesystem::path>(keyboardScript))
+            ("m,symbol-map", "Symbol map file of the program, which names its functions", cxxopts::value<std::filesystem::path>(symbolMapFilename))
+            ("p,profile", "Write a flat profile to 'arg'.txt and folded call stacks to 'arg'.folded, using the naive engine", cxxopts::value<std::filesystem::path>(profileFilename))
+            ("save-snapshot", "Run to the label given by 'snapshot-at', save a snapshot to 'arg', and continue the run", cxxopts::value<std::filesystem::path>(saveSnapshotFilename))
+            ("snapshot-at", "Label of the symbol map where the snapshot is saved", cxxopts::value<std::string>(snapshotLabel)->default_value("Main.main"))
+            ("load-snapshot", "Resume the run from the snapshot 'arg', before setting the RAM words", cxxopts::value<std::filesystem::path>(loadSnapshotFilename))
+            ("q,quiet", "Do not display the execution statistics", cxxopts::value<bool>(quiet))
+            ("r,ram", "Display the RAM word 'address' or words 'first:last' after the run", cxxopts::value<std::vector<std::string>>())
+            ("s,set", "Set the RAM word 'address=value' before the run", cxxopts::value<std::vector<std::string>>());
+
+        options.add_options("Positional")
+            ("input-file", "Input binary file", cxxopts::value<std::filesystem::path>());
+        // clang-format on
+
+        options.parse_positional("input-file");
+
+        const auto optionsMap = options.parse(argc, argv);
+
+        if (optionsMap.count("help") != 0)
+        {
+            std::cout << options.help() << '\n';
+            return EXIT_SUCCESS;
+        }
+
+        if (optionsMap.count("input-file") == 0)
+        {
+            throw cxxopts::option_required_exception{"input-file"};
+        }
+
+        const auto engine = n2t::findExecutionEngine(engineName);
+        if (!engine)
+        {
+            throw cxxopts::OptionParseException{
+                fmt::format("Option 'engine' has an invalid argument '{}'", engineName)};
+        }
+
+        std::optional<n2t::FrameFormat> frameFormat;
+        if (!framesDirectory.empty())
+        {
+            if (frameFormatName == "pbm")
+            {
+                frameFormat = n2t::FrameFormat::Pbm;
+            }
+            else if (frameFormatName == "raw")
+            {
+                frameFormat = n2t::FrameFormat::Raw;
+            }
+            else
+            {
+                throw cxxopts::OptionParseException{
+                    fmt::format("Option 'frame-format' has an invalid argument '{}'", frameFormatName)};
+            }
+            if (frameCycles == 0)
+            {
+                throw cxxopts::OptionParseException{"Option 'frame-cycles' must be positive"};
+            }
+        }
+
+        if (!profileFilename.empty() && symbolMapFilename.empty())
+        {
+            throw cxxopts::OptionParseException{"Option 'profile' requires option 'symbol-map'"};
+        }
+        if (!saveSnapshotFilename.empty() && symbolMapFilename.empty())
+        {
+            throw cxxopts::OptionParseException{"Option 'save-snapshot' requires option 'symbol-map'"};
+        }
+
+        std::vector<std::pair<uint16_t, uint16_t>> assignments;
+        if (optionsMap.count("set") != 0)
+        {
+            for (const auto& assignment : optionsMap["set"].as<std::vector<std::string>>())
+            {
+                assignments.push_back(n2t::parseRamAssignment(assignment, n2t::HackComputer::ramSize));
+            }
+        }
+
+        std::vector<std::pair<uint16_t, uint16_t>> ranges;
+        if (optionsMap.count("ram") != 0)
+        {
+            for (const auto& range : optionsMap["ram"].as<std::vector<std::string>>())
+            {
+                ranges.push_back(n2t::parseRamRange(range, n2t::HackComputer::ramSize));
+            }
+        }
+
+        /*
+         * Run program
+         */
+
+        n2t::SymbolMap symbols;
+        if (!symbolMapFilename.empty())
+        {
+            symbols = n2t::loadSymbolMap(symbolMapFilename);
+        }
+
+        n2t::HackComputer computer{n2t::loadRomImage(optionsMap["input-file"].as<std::filesystem::path>()), *engine};
+        if (!loadSnapshotFilename.empty())
+        {
+            n2t::loadSnapshot(loadSnapshotFilename, computer);
+        }
+        for (const auto& [address, value] : assignments)
+        {
+            computer.ram()[address] = value;
+        }
+
+        if (!saveSnapshotFilename.empty())
+        {
+            const auto label = std::find_if(symbols.begin(), symbols.end(), [&](const n2t::SymbolMapEntry& entry) {
+                return (entry.kind == n2t::SymbolKind::Label) && (entry.symbol == snapshotLabel);
+            });
+            n2t::throwUnless<std::runtime_error>(label != symbols.end(),
+                                                 "Label ({}) is not in the symbol map ({})",
+                                                 snapshotLabel,
+                                                 symbolMapFilename.string());
+
+            computer.runUntil(label->address, maxCycles - std::min(maxCycles, computer.cycles()));
+            n2t::throwUnless<std::runtime_error>(computer.pc() == label->address,
+                                                 "Program did not reach label ({}) after {} cycles",
+                                                 snapshotLabel,
+                                                 computer.cycles());
+            n2t::saveSnapshot(saveSnapshotFilename, computer);
+        }
+
+        std::optional<n2t::ScreenCapture> capture;
+        if (frameFormat)
+        {
+            capture.emplace(framesDirectory, *frameFormat);
+        }
+
+        std::optional<n2t::Profiler> profiler;
+        if (!profileFilename.empty())
+        {
+            profiler.emplace(symbols);
+            computer.attachProfiler(&*profiler);
+        }
+
+        std::optional<n2t::KeyboardScript> keyboard;
+        if (!keyboardScript.empty())
+        {
+            keyboard.emplace(keyboardScript);
+        }
+
+        const auto run = [&](uint64_t cycles) {
+            return keyboard ? keyboard->run(computer, cycles) : computer.run(cycles);
+        };
+
+        const auto startTime = std::chrono::steady_clock::now();
+        if (capture)
+        {
+            while (!computer.halted() && (computer.cycles() < maxCycles) && !(keyboard && keyboard->waiting()))
+            {
+                run(std::min(frameCycles, maxCycles - computer.cycles()));
+                capture->capture(computer);
+            }
+        }
+        else
+        {
+            run(maxCycles - std::min(maxCycles, computer.cycles()));
+        }
+        const auto elapsedTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        if (profiler)
+        {
+            auto filename = profileFilename;
+            profiler->writeFlatProfile(filename.concat(".txt"));
+            filename = profileFilename;
+            profiler->writeFoldedStacks(filename.concat(".folded"));
+        }
+
+        for (const auto& [first, last] : ranges)
+        {
+            for (auto address = first; address <= last; ++address)
+            {
+                std::cout << fmt::format("RAM[{}] = {}\n", address, static_cast<int16_t>(computer.ram()[address]));
+            }
+        }
+
+        if (!quiet)
+        {
+            std::string_view status = computer.halted() ? "Halted" : "Stopped";
+            if (keyboard && keyboard->waiting())
+            {
+                status = "Waiting for input";
+            }
+
+            std::cout << fmt::format("{} after {} cycles in {:.3f} s ({:.1f} MIPS)\n",
+                                     status,
+                                     computer.cycles(),
+                                     elapsedTime,
+                                     (elapsedTime > 0) ? (static_cast<double>(computer.cycles()) / elapsedTime / 1e6)
+                                                       : 0.0);
+            if (capture)
+            {
+                std::cout << fmt::format("Wrote {} frames\n", capture->frames());
+            }
+            if (keyboard)
+            {
+                std::cout << fmt::format("Skipped {} cycles waiting for input\n", keyboard->skippedCycles());
+            }
+        }
+    }
+    catch (const cxxopts::OptionException& ex)
+    {
+        result = EXIT_FAILURE;
+        std::cerr << "ERROR: " << ex.what() << "\n\n";
+        std::cout << options.help() << '\n';
+    }
+    catch (const std::exception& ex)
+    {
+        result = EXIT_FAILURE;
+        std::cerr << "ERROR: " << ex.what() << '\n';
+    }
+
+    return result;
+}
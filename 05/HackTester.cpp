@@ -0,0 +1,226 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "HackComputer.h"
+#include "TestFarm.h"
+#include "TestScript.h"
+
+#include <cxxopts.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+void findTestScripts(const std::filesystem::path& inputPath, std::vector<std::filesystem::path>& filenames)
+{
+    if (!std::filesystem::exists(inputPath))
+    {
+        throw std::invalid_argument{fmt::format("Input path ({}) does not exist", inputPath.string())};
+    }
+
+    if (std::filesystem::is_directory(inputPath))
+    {
+        const auto numFilenames = filenames.size();
+
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(inputPath))
+        {
+            const auto& path = entry.path();
+            if (std::filesystem::is_regular_file(path) && (path.extension() == ".tst"))
+            {
+                filenames.push_back(path);
+            }
+        }
+
+        if (filenames.size() == numFilenames)
+        {
+            throw std::invalid_argument{
+                fmt::format("Input directory ({}) does not contain test scripts", inputPath.string())};
+        }
+
+        // the directory order is unspecified
+        std::sort(filenames.begin() + static_cast<std::ptrdiff_t>(numFilenames), filenames.end());
+    }
+    else if (std::filesystem::is_regular_file(inputPath))
+    {
+        filenames.push_back(inputPath);
+    }
+    else
+    {
+        throw std::invalid_argument{fmt::format("Input path ({}) is not a file nor a directory", inputPath.string())};
+    }
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    int result = EXIT_SUCCESS;
+
+    const std::filesystem::path programPath{*argv};
+    cxxopts::Options            options{programPath.filename(), "Hack CPU Test Script Runner"};
+
+    try
+    {
+        /*
+         * Parse command line options
+         */
+
+        const int             maxThreads = std::max<int>(std::thread::hardware_concurrency(), 1);
+        auto                  numJobs    = maxThreads;
+        uint64_t              maxCycles  = std::numeric_limits<uint64_t>::max();
+        double                timeout    = 0.0;
+        std::string           engineName;
+        std::filesystem::path junitFilename;
+        bool                  quiet = false;
+
+        options.show_positional_help();
+
+        // clang-format off
+        options.add_options()
+            ("help", "Display this help message")
+            ("c,cycles", "Fail a test whose program runs more than 'arg' instructions", cxxopts::value<uint64_t>(maxCycles))
+            ("e,engine", "Execution engine (naive, predecoded, super, jit)", cxxopts::value<std::string>(engineName)->default_value("super"))
+            ("j,jobs", "Run 'arg' tests in parallel", cxxopts::value<int>(numJobs)->default_value(std::to_string(maxThreads)))
+            ("junit", "Write a JUnit XML report of the tests to 'arg'", cxxopts::value<std::filesystem::path>(junitFilename))
+            ("q,quiet", "Only display the failed tests", cxxopts::value<bool>(quiet))
+            ("t,timeout", "Fail a test which runs more than 'arg' seconds", cxxopts::value<double>(timeout));
+
+        options.add_options("Positional")
+            ("input-path", "Input test script files (.tst)/directories", cxxopts::value<std::vector<std::string>>());
+        // clang-format on
+
+        options.parse_positional("input-path");
+
+        const auto optionsMap = options.parse(argc, argv);
+
+        if (optionsMap.count("help") != 0)
+        {
+            std::cout << options.help() << '\n';
+            return EXIT_SUCCESS;
+        }
+
+        if (numJobs <= 0)
+        {
+            throw cxxopts::OptionParseException{fmt::format("Option 'jobs' has an invalid argument '{}'", numJobs)};
+        }
+        if (timeout < 0.0)
+        {
+            throw cxxopts::OptionParseException{fmt::format("Option 'timeout' has an invalid argument '{}'", timeout)};
+        }
+
+        n2t::TestOptions testOptions;
+        testOptions.maxCycles = maxCycles;
+        testOptions.timeout   = std::chrono::milliseconds{static_cast<int64_t>(timeout * 1000.0)};
+
+        const auto engine = n2t::findExecutionEngine(engineName);
+        if (!engine)
+        {
+            throw cxxopts::OptionParseException{
+                fmt::format("Option 'engine' has an invalid argument '{}'", engineName)};
+        }
+        testOptions.engine = *engine;
+
+        if (optionsMap.count("input-path") == 0)
+        {
+            throw cxxopts::option_required_exception{"input-path"};
+        }
+
+        std::vector<std::filesystem::path> filenames;
+        for (const auto& inputPath : optionsMap["input-path"].as<std::vector<std::string>>())
+        {
+            findTestScripts(inputPath, filenames);
+        }
+
+        /*
+         * Run test scripts
+         */
+
+        n2t::TestFarm farm{std::move(filenames), static_cast<unsigned int>(numJobs)};
+
+        std::size_t numFailed = 0;
+        const auto  startTime = std::chrono::steady_clock::now();
+        farm.run(testOptions, [&](const n2t::TestCase& test) {
+            if (!test.error.empty())
+            {
+                ++numFailed;
+                std::cerr << "ERROR: " << test.error << '\n';
+                return;
+            }
+
+            if (!test.result.passed)
+            {
+                ++numFailed;
+            }
+            if (!quiet || !test.result.passed)
+            {
+                for (const auto& echo : test.result.echoes)
+                {
+                    std::cout << fmt::format("{}: {}\n", test.filename.string(), echo);
+                }
+                std::cout << fmt::format("{}: {}\n", test.filename.string(), test.result.message);
+            }
+        });
+        const auto elapsedTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        if (!junitFilename.empty())
+        {
+            farm.writeJUnitReport(junitFilename, elapsedTime);
+        }
+
+        if (!quiet)
+        {
+            std::cout << fmt::format("{} of {} tests passed in {:.3f} s\n",
+                                     farm.tests().size() - numFailed,
+                                     farm.tests().size(),
+                                     elapsedTime);
+        }
+        if (numFailed != 0)
+        {
+            result = EXIT_FAILURE;
+        }
+    }
+    catch (const cxxopts::OptionException& ex)
+    {
+        result = EXIT_FAILURE;
+        std::cerr << "ERROR: " << ex.what() << "\n\n";
+        std::cout << options.help() << '\n';
+    }
+    catch (const std::exception& ex)
+    {
+        result = EXIT_FAILURE;
+        std::cerr << "ERROR: " << ex.what() << '\n';
+    }
+
+    return result;
+}
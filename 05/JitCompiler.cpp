@@ -0,0 +1,749 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "JitCompiler.h"
+
+#include <Util.h>
+
+#if N2T_JIT
+
+#include "Alu.h"
+#include "HackComputer.h"
+
+#include <RomImage.h>
+
+#include <sys/mman.h>
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <system_error>
+
+namespace
+{
+constexpr uint16_t cInstructionBit = 0x8000;
+constexpr uint16_t addressMask     = 0x7FFF;
+constexpr uint16_t compShift       = 6;
+constexpr uint16_t compMask        = 0x7F;
+constexpr uint16_t destA           = 0b100000;
+constexpr uint16_t destD           = 0b010000;
+constexpr uint16_t destM           = 0b001000;
+constexpr uint16_t destMask        = 0b111000;
+constexpr uint16_t jumpMask        = 0b000111;
+constexpr uint16_t jumpAlways      = 0b111;
+
+constexpr std::size_t bufferCapacity = 32 * 1024 * 1024;
+constexpr std::size_t maxBlockLength = 1024;
+constexpr uint32_t    hotThreshold   = 16;
+constexpr uint32_t    unknownValue   = 0xFFFFFFFF;
+
+// Register numbers of the x86-64 instruction encoding.
+enum Register : uint8_t
+{
+    rax = 0,
+    rcx = 1,
+    rdx = 2,
+    rsi = 6,
+    rdi = 7,
+    r8  = 8,
+    r9  = 9,
+    r10 = 10,
+    r11 = 11
+};
+
+// Registers of the generated code. The C-instructions compute the ALU output in 'outRegister', and the address of
+// the next instruction in 'pcRegister', which also holds the 'y' input of the ALU.
+constexpr Register stateRegister     = rdi;
+constexpr Register entriesRegister   = rsi;
+constexpr Register ramRegister       = rdx;
+constexpr Register aRegister         = r8;
+constexpr Register dRegister         = r9;
+constexpr Register remainingRegister = r10;
+constexpr Register addressRegister   = r11;
+constexpr Register outRegister       = rax;
+constexpr Register pcRegister        = rcx;
+
+// Condition codes of the x86-64 conditional jumps. Inverting the lowest bit inverts the condition.
+constexpr uint8_t conditionBelow        = 0x2;
+constexpr uint8_t conditionAboveOrEqual = 0x3;
+constexpr uint8_t conditionEqual        = 0x4;
+constexpr uint8_t conditionNotEqual     = 0x5;
+
+// Conditions of the 'jump' field, on the signed ALU output.
+// clang-format off
+constexpr std::array<uint8_t, 8> jumpConditions =
+{
+    0x0,  // no jump
+    0xF,  // JGT: greater
+    0x4,  // JEQ: equal
+    0xD,  // JGE: greater or equal
+    0xC,  // JLT: less
+    0x5,  // JNE: not equal
+    0xE,  // JLE: less or equal
+    0x0   // JMP: unconditional
+};
+// clang-format on
+
+// Emits x86-64 instructions into a buffer, for code that will be copied to the address 'base'. Only the few
+// instruction forms used by the generated code are supported.
+class Emitter
+{
+public:
+    explicit Emitter(const uint8_t* base) : m_base{base}
+    {
+    }
+
+    [[nodiscard]] const std::vector<uint8_t>& code() const
+    {
+        return m_code;
+    }
+
+    [[nodiscard]] const uint8_t* address() const
+    {
+        return m_base + m_code.size();
+    }
+
+    // mov dst, src (32 bits, or 64 bits if 'wide')
+    void move(Register dst, Register src, bool wide = false)
+    {
+        registerOperation(0x89, src, dst, wide);
+    }
+
+    // mov dst, value
+    void moveImmediate(Register dst, uint32_t value)
+    {
+        rex(false, 0, 0, dst);
+        byte(static_cast<uint8_t>(0xB8 + (dst & 0x7)));
+        imm32(value);
+    }
+
+    // add dst, src
+    void add(Register dst, Register src)
+    {
+        registerOperation(0x01, src, dst);
+    }
+
+    // and dst, src
+    void bitwiseAnd(Register dst, Register src)
+    {
+        registerOperation(0x21, src, dst);
+    }
+
+    // and dst, value
+    void bitwiseAndImmediate(Register dst, uint32_t value)
+    {
+        immediateOperation(4, dst, value);
+    }
+
+    // xor dst, dst
+    void zero(Register dst)
+    {
+        registerOperation(0x31, dst, dst);
+    }
+
+    // not dst
+    void bitwiseNot(Register dst)
+    {
+        rex(false, 0, 0, dst);
+        byte(0xF7);
+        modrm(0b11, 2, dst);
+    }
+
+    // movzx dst, src (16 bits)
+    void zeroExtend(Register dst, Register src)
+    {
+        rex(false, dst, 0, src);
+        byte(0x0F);
+        byte(0xB7);
+        modrm(0b11, dst, src);
+    }
+
+    // cmp dst, value (32 bits, or 64 bits if 'wide')
+    void compareImmediate(Register dst, uint32_t value, bool wide = false)
+    {
+        immediateOperation(7, dst, value, wide);
+    }
+
+    // sub dst, value (32 bits, or 64 bits if 'wide')
+    void subtractImmediate(Register dst, uint32_t value, bool wide = false)
+    {
+        immediateOperation(5, dst, value, wide);
+    }
+
+    // test src, src (16 bits, or 64 bits if 'wide')
+    void test(Register src, bool wide = false)
+    {
+        if (!wide)
+        {
+            byte(0x66);
+        }
+        registerOperation(0x85, src, src, wide);
+    }
+
+    // movzx dst, word [ram + index * 2]
+    void loadRam(Register dst, Register index)
+    {
+        rex(false, dst, index, ramRegister);
+        byte(0x0F);
+        byte(0xB7);
+        indexedOperand(dst, index, ramRegister, 1);
+    }
+
+    // movzx dst, word [ram + address * 2]
+    void loadRam(Register dst, uint16_t address)
+    {
+        rex(false, dst, 0, ramRegister);
+        byte(0x0F);
+        byte(0xB7);
+        modrm(0b10, dst, ramRegister);
+        imm32(address * 2U);
+    }
+
+    // mov word [ram + index * 2], src
+    void storeRam(Register src, Register index)
+    {
+        byte(0x66);
+        rex(false, src, index, ramRegister);
+        byte(0x89);
+        indexedOperand(src, index, ramRegister, 1);
+    }
+
+    // mov word [ram + address * 2], src
+    void storeRam(Register src, uint16_t address)
+    {
+        byte(0x66);
+        rex(false, src, 0, ramRegister);
+        byte(0x89);
+        modrm(0b10, src, ramRegister);
+        imm32(address * 2U);
+    }
+
+    // mov dst, qword [entries + index * 8]
+    void loadEntry(Register dst, Register index)
+    {
+        rex(true, dst, index, entriesRegister);
+        byte(0x8B);
+        indexedOperand(dst, index, entriesRegister, 3);
+    }
+
+    // mov dst, qword [state + offset]
+    void loadField(Register dst, std::size_t offset)
+    {
+        rex(true, dst, 0, stateRegister);
+        byte(0x8B);
+        fieldOperand(dst, offset);
+    }
+
+    // movzx dst, word [state + offset]
+    void loadWordField(Register dst, std::size_t offset)
+    {
+        rex(false, dst, 0, stateRegister);
+        byte(0x0F);
+        byte(0xB7);
+        fieldOperand(dst, offset);
+    }
+
+    // mov qword [state + offset], src
+    void storeField(Register src, std::size_t offset)
+    {
+        rex(true, src, 0, stateRegister);
+        byte(0x89);
+        fieldOperand(src, offset);
+    }
+
+    // mov word [state + offset], src
+    void storeWordField(Register src, std::size_t offset)
+    {
+        byte(0x66);
+        rex(false, src, 0, stateRegister);
+        byte(0x89);
+        fieldOperand(src, offset);
+    }
+
+    // mov byte [state + offset], value
+    void storeByteField(std::size_t offset, uint8_t value)
+    {
+        byte(0xC6);
+        fieldOperand(0, offset);
+        byte(value);
+    }
+
+    // bts qword [base], offset
+    void bitTestAndSet(Register base, Register offset)
+    {
+        rex(true, offset, 0, base);
+        byte(0x0F);
+        byte(0xAB);
+        modrm(0b00, offset, base);
+    }
+
+    // jmp target
+    void jump(Register target)
+    {
+        rex(false, 0, 0, target);
+        byte(0xFF);
+        modrm(0b11, 4, target);
+    }
+
+    // jmp target
+    void jump(const uint8_t* target)
+    {
+        byte(0xE9);
+        relative(target);
+    }
+
+    // jcc target
+    void jumpIf(uint8_t condition, const uint8_t* target)
+    {
+        byte(0x0F);
+        byte(static_cast<uint8_t>(0x80 | condition));
+        relative(target);
+    }
+
+    // jcc to a target emitted later, whose position is given to 'patch'
+    [[nodiscard]] std::size_t jumpIfForward(uint8_t condition)
+    {
+        byte(0x0F);
+        byte(static_cast<uint8_t>(0x80 | condition));
+        const auto position = m_code.size();
+        imm32(0);
+        return position;
+    }
+
+    // Makes the forward jump at 'position' jump to the current address.
+    void patch(std::size_t position)
+    {
+        const auto displacement = static_cast<uint32_t>(m_code.size() - (position + 4));
+        std::memcpy(&m_code[position], &displacement, sizeof(displacement));
+    }
+
+    void ret()
+    {
+        byte(0xC3);
+    }
+
+private:
+    void byte(uint8_t value)
+    {
+        m_code.push_back(value);
+    }
+
+    void imm32(uint32_t value)
+    {
+        for (auto shift = 0; shift < 32; shift += 8)
+        {
+            byte(static_cast<uint8_t>(value >> shift));
+        }
+    }
+
+    void relative(const uint8_t* target)
+    {
+        imm32(static_cast<uint32_t>(target - (address() + 4)));
+    }
+
+    // Emits the REX prefix if any of its bits is set.
+    void rex(bool wide, unsigned reg, unsigned index, unsigned base)
+    {
+        const auto prefix = static_cast<uint8_t>(0x40 | (wide ? 0x8 : 0) | ((reg & 0x8) >> 1) | ((index & 0x8) >> 2) |
+                                                 ((base & 0x8) >> 3));
+        if (prefix != 0x40)
+        {
+            byte(prefix);
+        }
+    }
+
+    void modrm(unsigned mod, unsigned reg, unsigned rm)
+    {
+        byte(static_cast<uint8_t>((mod << 6) | ((reg & 0x7) << 3) | (rm & 0x7)));
+    }
+
+    void registerOperation(uint8_t opcode, Register reg, Register rm, bool wide = false)
+    {
+        rex(wide, reg, 0, rm);
+        byte(opcode);
+        modrm(0b11, reg, rm);
+    }
+
+    void immediateOperation(unsigned extension, Register dst, uint32_t value, bool wide = false)
+    {
+        rex(wide, 0, 0, dst);
+        byte(0x81);
+        modrm(0b11, extension, dst);
+        imm32(value);
+    }
+
+    // [base + index * (1 << scale)], where base is neither rbp nor r13
+    void indexedOperand(unsigned reg, Register index, Register base, unsigned scale)
+    {
+        modrm(0b00, reg, 0b100);
+        byte(static_cast<uint8_t>((scale << 6) | ((index & 0x7) << 3) | (base & 0x7)));
+    }
+
+    // [state + offset]
+    void fieldOperand(unsigned reg, std::size_t offset)
+    {
+        modrm(0b01, reg, stateRegister);
+        byte(static_cast<uint8_t>(offset));
+    }
+
+    const uint8_t*       m_base;
+    std::vector<uint8_t> m_code;
+};
+
+// Makes the code buffer writable or executable, but never both.
+void protect(uint8_t* buffer, bool executable)
+{
+    const auto protection = executable ? (PROT_READ | PROT_EXEC) : (PROT_READ | PROT_WRITE);
+    if (mprotect(buffer, bufferCapacity, protection) != 0)
+    {
+        throw std::system_error{errno, std::generic_category(), "Could not protect the JIT code buffer"};
+    }
+}
+}  // namespace
+
+n2t::JitCompiler::JitCompiler(std::span<const uint16_t> rom) :
+    m_rom{rom}, m_entries(romSize, nullptr), m_counters(romSize, 0)
+{
+    auto* buffer = mmap(nullptr, bufferCapacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED)
+    {
+        throw std::system_error{errno, std::generic_category(), "Could not allocate the JIT code buffer"};
+    }
+    m_buffer = static_cast<uint8_t*>(buffer);
+
+    Emitter emitter{m_buffer};
+
+    // enter(state, code): loads the registers from the state, and jumps to the code
+    m_enter = emitter.address();
+    emitter.move(addressRegister, rsi, true);
+    emitter.loadField(ramRegister, offsetof(JitState, ram));
+    emitter.loadField(entriesRegister, offsetof(JitState, entries));
+    emitter.loadField(remainingRegister, offsetof(JitState, remaining));
+    emitter.loadWordField(aRegister, offsetof(JitState, a));
+    emitter.loadWordField(dRegister, offsetof(JitState, d));
+    emitter.jump(addressRegister);
+
+    // dispatch: jumps to the compiled block of the PC, or falls through to exit
+    m_dispatch = emitter.address();
+    emitter.loadEntry(rax, pcRegister);
+    emitter.test(rax, true);
+    const auto notCompiled = emitter.jumpIfForward(conditionEqual);
+    emitter.jump(rax);
+    emitter.patch(notCompiled);
+
+    // exit: stores the registers into the state, and returns
+    m_exit = emitter.address();
+    emitter.storeWordField(aRegister, offsetof(JitState, a));
+    emitter.storeWordField(dRegister, offsetof(JitState, d));
+    emitter.storeWordField(pcRegister, offsetof(JitState, pc));
+    emitter.storeField(remainingRegister, offsetof(JitState, remaining));
+    emitter.ret();
+
+    std::memcpy(m_buffer, emitter.code().data(), emitter.code().size());
+    m_size = emitter.code().size();
+    protect(m_buffer, true);
+}
+
+n2t::JitCompiler::~JitCompiler() noexcept
+{
+    munmap(m_buffer, bufferCapacity);
+}
+
+const uint8_t* n2t::JitCompiler::find(uint16_t address, bool entry)
+{
+    const auto* code = m_entries[address];
+    if ((code == nullptr) && entry && (++m_counters[address] == hotThreshold))
+    {
+        code = compile(address);
+    }
+    return code;
+}
+
+void n2t::JitCompiler::execute(const uint8_t* code, JitState& state) const
+{
+    using Enter = void (*)(JitState*, const uint8_t*);
+
+    // an object pointer cannot be cast to a function pointer in standard C++
+    Enter enter = nullptr;
+    static_assert(sizeof(enter) == sizeof(m_enter));
+    std::memcpy(&enter, &m_enter, sizeof(enter));
+
+    state.entries = m_entries.data();
+    enter(&state, code);
+}
+
+const uint8_t* n2t::JitCompiler::compile(uint16_t address)
+{
+    const auto size = m_rom.size();
+
+    // the block ends after its first jump
+    std::size_t end = address;
+    while ((end < size) && ((end - address) < maxBlockLength))
+    {
+        const auto instruction = m_rom[end++];
+        if (((instruction & cInstructionBit) != 0) && ((instruction & jumpMask) != 0))
+        {
+            break;
+        }
+    }
+    const auto length = static_cast<uint32_t>(end - address);
+
+    auto*   code = m_buffer + m_size;
+    Emitter emitter{code};
+
+    // the whole block is executed only if enough cycles remain
+    emitter.compareImmediate(remainingRegister, length, true);
+    const auto notEnoughCycles = emitter.jumpIfForward(conditionBelow);
+    emitter.subtractImmediate(remainingRegister, length, true);
+
+    // value of the A register, if it is known at compile time
+    auto a = unknownValue;
+
+    auto lastJump = uint16_t{0};
+    for (auto pc = std::size_t{address}; pc < end; ++pc)
+    {
+        const auto instruction = m_rom[pc];
+        if ((instruction & cInstructionBit) == 0)
+        {
+            emitter.moveImmediate(aRegister, instruction);
+            a = instruction;
+            continue;
+        }
+
+        const auto comp = static_cast<uint16_t>((instruction >> compShift) & compMask);
+        const auto dest = static_cast<uint16_t>(instruction & destMask);
+        const auto jump = static_cast<uint16_t>(instruction & jumpMask);
+        if ((dest == 0) && (jump == 0))
+        {
+            continue;
+        }
+
+        const bool useM = (comp & 0b1000000) != 0;
+        const bool zx   = (comp & 0b0100000) != 0;
+        const bool nx   = (comp & 0b0010000) != 0;
+        const bool zy   = (comp & 0b0001000) != 0;
+        const bool ny   = (comp & 0b0000100) != 0;
+        const bool f    = (comp & 0b0000010) != 0;
+        const bool no   = (comp & 0b0000001) != 0;
+
+        // the address of M, unless it is known at compile time
+        if (((useM && !zy) || ((dest & destM) != 0)) && (a == unknownValue))
+        {
+            emitter.move(addressRegister, aRegister);
+            emitter.bitwiseAndImmediate(addressRegister, addressMask);
+        }
+
+        if (zx && zy)
+        {
+            // the output does not depend on the registers
+            emitter.moveImmediate(outRegister, aluTable[comp](0, 0, 0));
+        }
+        else
+        {
+            if (zx)
+            {
+                emitter.zero(outRegister);
+            }
+            else
+            {
+                emitter.move(outRegister, dRegister);
+            }
+            if (nx)
+            {
+                emitter.bitwiseNot(outRegister);
+            }
+
+            if (zy)
+            {
+                emitter.zero(pcRegister);
+            }
+            else if (useM && (a != unknownValue))
+            {
+                emitter.loadRam(pcRegister, static_cast<uint16_t>(a & addressMask));
+            }
+            else if (useM)
+            {
+                emitter.loadRam(pcRegister, addressRegister);
+            }
+            else
+            {
+                emitter.move(pcRegister, aRegister);
+            }
+            if (ny)
+            {
+                emitter.bitwiseNot(pcRegister);
+            }
+
+            if (f)
+            {
+                emitter.add(outRegister, pcRegister);
+            }
+            else
+            {
+                emitter.bitwiseAnd(outRegister, pcRegister);
+            }
+            if (no)
+            {
+                emitter.bitwiseNot(outRegister);
+            }
+        }
+
+        if (((dest & destM) != 0) && (a != unknownValue))
+        {
+            const auto address = static_cast<uint16_t>(a & addressMask);
+            emitter.storeRam(outRegister, address);
+
+            const auto offset = static_cast<uint16_t>(address - HackComputer::screenAddress);
+            if (offset < HackComputer::screenSize)
+            {
+                emitter.moveImmediate(pcRegister, offset);
+                emitter.loadField(addressRegister, offsetof(JitState, screenChanges));
+                emitter.bitTestAndSet(addressRegister, pcRegister);
+            }
+        }
+        else if ((dest & destM) != 0)
+        {
+            emitter.storeRam(outRegister, addressRegister);
+
+            // marks the written word if it belongs to the screen memory map
+            emitter.move(pcRegister, addressRegister);
+            emitter.subtractImmediate(pcRegister, HackComputer::screenAddress);
+            emitter.compareImmediate(pcRegister, HackComputer::screenSize);
+            const auto notScreen = emitter.jumpIfForward(conditionAboveOrEqual);
+            emitter.loadField(addressRegister, offsetof(JitState, screenChanges));
+            emitter.bitTestAndSet(addressRegister, pcRegister);
+            emitter.patch(notScreen);
+        }
+        if ((dest & destD) != 0)
+        {
+            emitter.zeroExtend(dRegister, outRegister);
+        }
+
+        // the jump target is the value of A before the instruction
+        if ((jump != 0) && (a != unknownValue))
+        {
+            emitter.moveImmediate(pcRegister, a & addressMask);
+        }
+        else if (jump != 0)
+        {
+            emitter.move(pcRegister, aRegister);
+            emitter.bitwiseAndImmediate(pcRegister, addressMask);
+        }
+
+        if ((dest & destA) != 0)
+        {
+            emitter.zeroExtend(aRegister, outRegister);
+            a = unknownValue;
+        }
+
+        if (jump == 0)
+        {
+            continue;
+        }
+
+        std::optional<std::size_t> notTaken;
+        if (jump != jumpAlways)
+        {
+            emitter.test(outRegister);
+            notTaken = emitter.jumpIfForward(jumpConditions[jump] ^ 1);
+        }
+
+        // a jump to the preceding '@target' which changes no state loops forever
+        const auto previous = static_cast<uint16_t>(pc - 1);
+        if ((dest == 0) && (pc != 0) && (m_rom[previous] == previous) &&
+            ((a == unknownValue) || (a == previous)))
+        {
+            if (a == unknownValue)
+            {
+                emitter.compareImmediate(aRegister, previous);
+                emitter.jumpIf(conditionNotEqual, m_dispatch);
+            }
+            emitter.storeByteField(offsetof(JitState, halted), 1);
+            emitter.jump(m_exit);
+        }
+        else if ((a != unknownValue) && (m_entries[a & addressMask] != nullptr))
+        {
+            emitter.jump(m_entries[a & addressMask]);
+        }
+        else
+        {
+            emitter.jump(m_dispatch);
+        }
+
+        if (notTaken)
+        {
+            emitter.patch(*notTaken);
+        }
+        lastJump = jump;
+    }
+
+    if ((lastJump != jumpAlways) && (end < size) && (m_entries[end] != nullptr))
+    {
+        emitter.jump(m_entries[end]);
+    }
+    else if (lastJump != jumpAlways)
+    {
+        emitter.moveImmediate(pcRegister, static_cast<uint32_t>(end));
+        emitter.jump(m_dispatch);
+    }
+
+    emitter.patch(notEnoughCycles);
+    emitter.moveImmediate(pcRegister, address);
+    emitter.jump(m_exit);
+
+    if ((m_size + emitter.code().size()) > bufferCapacity)
+    {
+        return nullptr;
+    }
+
+    protect(m_buffer, false);
+    std::memcpy(code, emitter.code().data(), emitter.code().size());
+    protect(m_buffer, true);
+
+    m_size += emitter.code().size();
+    m_entries[address] = code;
+    return code;
+}
+
+#else
+
+n2t::JitCompiler::JitCompiler(std::span<const uint16_t> rom) : m_rom{rom}
+{
+    throwAlways("The JIT compiler is not supported on this platform");
+}
+
+n2t::JitCompiler::~JitCompiler() noexcept = default;
+
+const uint8_t* n2t::JitCompiler::find(uint16_t /*address*/, bool /*entry*/)
+{
+    return nullptr;
+}
+
+void n2t::JitCompiler::execute(const uint8_t* /*code*/, JitState& /*state*/) const
+{
+}
+
+#endif
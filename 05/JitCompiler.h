@@ -0,0 +1,102 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef N2T_JIT_COMPILER_H
+#define N2T_JIT_COMPILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// The JIT compiler generates x86-64 code, and allocates executable memory with the Linux system calls.
+#if defined(__x86_64__) && defined(__linux__) && !defined(N2T_NO_JIT)
+#define N2T_JIT 1
+#else
+#define N2T_JIT 0
+#endif
+
+namespace n2t
+{
+// State of the computer shared with the generated code.
+struct JitState
+{
+    uint16_t*             ram           = nullptr;
+    uint64_t*             screenChanges = nullptr;  // bitmap of the written words of the screen memory map
+    const uint8_t* const* entries       = nullptr;
+    uint64_t              remaining     = 0;  // cycles that the generated code may execute
+    uint16_t              a             = 0;
+    uint16_t              d             = 0;
+    uint16_t              pc            = 0;
+    bool                  halted        = false;
+};
+
+// Compiles the basic blocks of a Hack program to x86-64 code. A block is compiled once it has been entered often
+// enough, and runs from its first instruction to the first jump. The A and D registers, the RAM base address and
+// the remaining cycles stay in host registers while the generated code runs. Each block checks that the remaining
+// cycles cover the whole block before executing it, and then jumps directly to the compiled block of the next
+// address if there is one, so that only cold code and the last cycles return to the interpreter.
+class JitCompiler
+{
+public:
+    explicit JitCompiler(std::span<const uint16_t> rom);
+
+    JitCompiler(const JitCompiler&) = delete;
+    JitCompiler(JitCompiler&&)      = delete;
+
+    JitCompiler& operator=(const JitCompiler&) = delete;
+    JitCompiler& operator=(JitCompiler&&) = delete;
+
+    ~JitCompiler() noexcept;
+
+    // Returns the compiled block starting at 'address', or nullptr if there is none. An entry into a block counts
+    // towards its compilation.
+    [[nodiscard]] const uint8_t* find(uint16_t address, bool entry);
+
+    // Runs the generated code from the compiled block 'code', until the remaining cycles do not cover the next block,
+    // the next block is not compiled, or the program halts.
+    void execute(const uint8_t* code, JitState& state) const;
+
+    [[nodiscard]] const uint8_t* const* entries() const
+    {
+        return m_entries.data();
+    }
+
+private:
+    // Appends the compiled block starting at 'address' to the code buffer, and returns its entry point, or nullptr
+    // if the code buffer is full.
+    const uint8_t* compile(uint16_t address);
+
+    std::span<const uint16_t>   m_rom;
+    std::vector<const uint8_t*> m_entries;
+    std::vector<uint32_t>       m_counters;
+    uint8_t*                    m_buffer   = nullptr;
+    std::size_t                 m_size     = 0;
+    const uint8_t*              m_enter    = nullptr;  // loads the registers from a JitState and jumps to a block
+    const uint8_t*              m_dispatch = nullptr;  // jumps to the compiled block of the PC, if any
+    const uint8_t*              m_exit     = nullptr;  // stores the registers into the JitState and returns
+};
+}  // namespace n2t
+
+#endif
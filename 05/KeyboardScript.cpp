@@ -0,0 +1,230 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "KeyboardScript.h"
+
+#include <MappedFile.h>
+#include <Util.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <limits>
+#include <string_view>
+#include <utility>
+
+namespace
+{
+// The state of the computer is checked for repetition after each slice of cycles.
+constexpr uint64_t sliceCycles = 1000000;
+constexpr uint64_t maxPeriod   = 10000;
+constexpr unsigned maxMatches  = 16;
+
+// Codes of the action keys, as recognized by the Jack OS.
+// clang-format off
+constexpr std::array<std::pair<std::string_view, uint16_t>, 25> keyNames =
+{{
+    {"ENTER", 128}, {"BACKSPACE", 129}, {"LEFT", 130}, {"UP", 131}, {"RIGHT", 132}, {"DOWN", 133},
+    {"HOME", 134}, {"END", 135}, {"PAGEUP", 136}, {"PAGEDOWN", 137}, {"INSERT", 138}, {"DELETE", 139},
+    {"ESC", 140}, {"F1", 141}, {"F2", 142}, {"F3", 143}, {"F4", 144}, {"F5", 145}, {"F6", 146}, {"F7", 147},
+    {"F8", 148}, {"F9", 149}, {"F10", 150}, {"F11", 151}, {"F12", 152}
+}};
+// clang-format on
+
+template<typename Value>
+[[nodiscard]] bool parseNumber(std::string_view text, Value& value)
+{
+    const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return (result.ec == std::errc{}) && (result.ptr == (text.data() + text.size()));
+}
+
+[[nodiscard]] bool parseKey(std::string_view text, uint16_t& key)
+{
+    if ((text.size() == 3) && (text.front() == '\'') && (text.back() == '\''))
+    {
+        key = static_cast<unsigned char>(text[1]);
+        return true;
+    }
+
+    const auto* name = std::find_if(keyNames.begin(), keyNames.end(), [&](const auto& entry) {
+        return entry.first == text;
+    });
+    if (name != keyNames.end())
+    {
+        key = name->second;
+        return true;
+    }
+
+    return parseNumber(text, key);
+}
+}  // namespace
+
+n2t::KeyboardScript::KeyboardScript(const std::filesystem::path& filename)
+{
+    const MappedFile file{filename};
+    const auto       name     = filename.filename().string();
+    auto             contents = file.contents();
+
+    unsigned int lineNumber = 0;
+    while (!contents.empty())
+    {
+        ++lineNumber;
+
+        const auto lineEnd = std::min(contents.find('\n'), contents.size());
+        auto       line    = contents.substr(0, lineEnd);
+        contents.remove_prefix(std::min(lineEnd + 1, contents.size()));
+
+        line = line.substr(0, line.find('#'));
+        while (!line.empty() && ((line.back() == ' ') || (line.back() == '\t') || (line.back() == '\r')))
+        {
+            line.remove_suffix(1);
+        }
+        while (!line.empty() && ((line.front() == ' ') || (line.front() == '\t')))
+        {
+            line.remove_prefix(1);
+        }
+        if (line.empty())
+        {
+            continue;
+        }
+
+        // <cycle> <key> or poll <key>
+        const auto separator = line.find_first_of(" \t");
+        throwUnless(separator != std::string_view::npos, {name, lineNumber}, "Invalid keyboard event ({})", line);
+
+        const auto when = line.substr(0, separator);
+        auto       key  = line.substr(separator + 1);
+        key.remove_prefix(std::min(key.find_first_not_of(" \t"), key.size()));
+
+        KeyEvent event;
+        event.onPoll = (when == "poll");
+        throwUnless(event.onPoll || parseNumber(when, event.cycle),
+                    {name, lineNumber},
+                    "Invalid cycle ({}) in keyboard event",
+                    when);
+        throwUnless(parseKey(key, event.key), {name, lineNumber}, "Invalid key ({}) in keyboard event", key);
+        throwUnless(event.onPoll || m_events.empty() || m_events.back().onPoll ||
+                        (m_events.back().cycle <= event.cycle),
+                    {name, lineNumber},
+                    "Keyboard event at cycle ({}) precedes the previous event",
+                    event.cycle);
+
+        m_events.push_back(event);
+    }
+}
+
+uint64_t n2t::KeyboardScript::run(HackComputer& computer, uint64_t maxCycles)
+{
+    const auto start = computer.cycles();
+    const auto end   = start + std::min(maxCycles, std::numeric_limits<uint64_t>::max() - start);
+
+    m_waiting = false;
+    while (!computer.halted() && (computer.cycles() < end))
+    {
+        while ((m_nextEvent < m_events.size()) && !m_events[m_nextEvent].onPoll &&
+               (m_events[m_nextEvent].cycle <= computer.cycles()))
+        {
+            press(computer);
+        }
+
+        auto limit = end;
+        if ((m_nextEvent < m_events.size()) && !m_events[m_nextEvent].onPoll)
+        {
+            limit = std::min(limit, m_events[m_nextEvent].cycle);
+        }
+
+        // the program keeps waiting for input until the next event
+        if (m_idlePeriod == 0)
+        {
+            // leaves cycles to look for a loop before the limit
+            computer.run(std::min((limit - computer.cycles()) / 2, sliceCycles));
+            if (computer.halted())
+            {
+                continue;
+            }
+
+            m_idlePeriod = findIdleLoop(computer, limit - computer.cycles());
+            if (m_idlePeriod == 0)
+            {
+                continue;
+            }
+        }
+
+        if (m_nextEvent == m_events.size())
+        {
+            m_waiting = true;
+            break;
+        }
+        if (m_events[m_nextEvent].onPoll)
+        {
+            press(computer);
+            continue;
+        }
+
+        // skips the whole periods of the loop before the next event, and executes the rest
+        const auto remaining = limit - computer.cycles();
+        const auto skipped   = remaining - (remaining % m_idlePeriod);
+        computer.skipCycles(skipped);
+        m_skippedCycles += skipped;
+        computer.run(remaining % m_idlePeriod);
+    }
+
+    return computer.cycles() - start;
+}
+
+void n2t::KeyboardScript::press(HackComputer& computer)
+{
+    computer.ram()[HackComputer::keyboardAddress] = m_events[m_nextEvent++].key;
+    m_idlePeriod = 0;
+}
+
+uint64_t n2t::KeyboardScript::findIdleLoop(HackComputer& computer, uint64_t maxCycles)
+{
+    const auto pc = computer.pc();
+    const auto a  = computer.a();
+    const auto d  = computer.d();
+    m_snapshot.assign(computer.ram().begin(), computer.ram().end());
+
+    unsigned matches = 0;
+    for (uint64_t period = 1; period <= std::min(maxPeriod, maxCycles); ++period)
+    {
+        if ((computer.run(1) == 0) || computer.halted())
+        {
+            return 0;
+        }
+        if ((computer.pc() == pc) && (computer.a() == a) && (computer.d() == d))
+        {
+            if (std::equal(m_snapshot.begin(), m_snapshot.end(), computer.ram().begin()))
+            {
+                return period;
+            }
+            if (++matches == maxMatches)
+            {
+                return 0;
+            }
+        }
+    }
+
+    return 0;
+}
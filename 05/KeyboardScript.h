@@ -0,0 +1,91 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef N2T_KEYBOARD_SCRIPT_H
+#define N2T_KEYBOARD_SCRIPT_H
+
+#include "HackComputer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace n2t
+{
+// Key code written to the keyboard memory map, either at a given cycle, or as soon as the program waits for input.
+struct KeyEvent
+{
+    bool     onPoll = false;
+    uint64_t cycle  = 0;
+    uint16_t key    = 0;
+};
+
+// Drives the keyboard of a Hack computer from a script, and skips the cycles that the program spends waiting for
+// input. The program waits for input when the whole state of the computer repeats, which happens in the loops that
+// poll the keyboard until its value changes. As the computer is deterministic, such a loop keeps repeating until the
+// next event, so its whole periods are skipped by only advancing the cycle count, which leaves the computer in the
+// state it would have reached by executing them.
+//
+// The script has one event per line, either '<cycle> <key>' or 'poll <key>', where the key is a decimal code, a
+// quoted character such as 'a', or the name of an action key such as ENTER, ESC or F1. A key is held until the
+// script releases it with key 0, and '#' starts a comment.
+class KeyboardScript
+{
+public:
+    explicit KeyboardScript(const std::filesystem::path& filename);
+
+    // Runs the computer for at most 'maxCycles' cycles, including the skipped cycles, and returns the number of
+    // cycles run. Stops early if the program halts, or waits for input after the last event.
+    uint64_t run(HackComputer& computer, uint64_t maxCycles);
+
+    // Returns whether the program waits for input after the last event.
+    [[nodiscard]] bool waiting() const
+    {
+        return m_waiting;
+    }
+
+    [[nodiscard]] uint64_t skippedCycles() const
+    {
+        return m_skippedCycles;
+    }
+
+private:
+    // Writes the key of the next event into the keyboard memory map.
+    void press(HackComputer& computer);
+
+    // Executes instructions until the state of the computer repeats, and returns the period of the loop, or 0 if the
+    // state did not repeat within a bounded number of cycles.
+    uint64_t findIdleLoop(HackComputer& computer, uint64_t maxCycles);
+
+    std::vector<KeyEvent> m_events;
+    std::size_t           m_nextEvent = 0;
+    std::vector<uint16_t> m_snapshot;
+    uint64_t              m_idlePeriod    = 0;  // period of the loop in which the program waits for input, if any
+    bool                  m_waiting       = false;
+    uint64_t              m_skippedCycles = 0;
+};
+}  // namespace n2t
+
+#endif
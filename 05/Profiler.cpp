@@ -0,0 +1,210 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Profiler.h"
+
+#include <RomImage.h>
+#include <Util.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+constexpr uint16_t addressMask    = 0x7FFF;
+constexpr uint16_t noReturn       = 0xFFFF;  // return address of the outermost call stack entry
+constexpr uint16_t spAddress      = 0;
+constexpr uint16_t lclAddress     = 1;
+constexpr uint16_t savedFrameSize = 5;
+
+void writeFile(const std::filesystem::path& filename, const fmt::memory_buffer& buffer)
+{
+    std::ofstream file{filename, std::ios::binary};
+    n2t::throwUnless<std::runtime_error>(file.good(), "Could not open output file ({})", filename.string());
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    n2t::throwUnless<std::runtime_error>(file.good(), "Could not write output file ({})", filename.string());
+}
+}  // namespace
+
+n2t::Profiler::Profiler(const SymbolMap& symbols) :
+    m_functions{"(bootstrap)"},
+    m_functionAt(romSize + 1, 0),
+    m_entries(romSize + 1, false),
+    m_counts(romSize + 1, 0)
+{
+    std::vector<std::pair<uint16_t, uint32_t>> entryPoints;
+    for (const auto& entry : symbols)
+    {
+        if ((entry.kind == SymbolKind::Label) && (entry.symbol.find('$') == std::string::npos) &&
+            (entry.address <= romSize))
+        {
+            entryPoints.emplace_back(entry.address, static_cast<uint32_t>(m_functions.size()));
+            m_functions.push_back(entry.symbol);
+        }
+    }
+    std::sort(entryPoints.begin(), entryPoints.end());
+
+    auto function = uint32_t{0};
+    auto next     = entryPoints.begin();
+    for (std::size_t address = 0; address <= romSize; ++address)
+    {
+        for (; (next != entryPoints.end()) && (next->first == address); ++next)
+        {
+            function           = next->second;
+            m_entries[address] = true;
+        }
+        m_functionAt[address] = function;
+    }
+
+    m_calls.resize(m_functions.size(), 0);
+    start(0);
+}
+
+void n2t::Profiler::start(uint16_t pc)
+{
+    attribute();
+
+    m_nodes.clear();
+    m_children.clear();
+    m_nodes.push_back(Node{m_functionAt[pc]});
+    m_stack.assign(1, Frame{0, noReturn, 0});
+}
+
+void n2t::Profiler::writeFlatProfile(const std::filesystem::path& filename)
+{
+    std::vector<uint64_t> instructions(m_functions.size(), 0);
+    for (std::size_t address = 0; address < m_counts.size(); ++address)
+    {
+        instructions[m_functionAt[address]] += m_counts[address];
+    }
+
+    std::vector<uint32_t> order(m_functions.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs) {
+        return instructions[lhs] > instructions[rhs];
+    });
+
+    const auto total = std::max<uint64_t>(m_instructions, 1);
+
+    fmt::memory_buffer buffer;
+    auto               out = std::back_inserter(buffer);
+    fmt::format_to(out, "{:>14} {:>7} {:>10}  {}\n", "Instructions", "%", "Calls", "Function");
+    for (const auto function : order)
+    {
+        if (instructions[function] == 0)
+        {
+            break;
+        }
+        fmt::format_to(out,
+                       "{:>14} {:>6.2f}% {:>10}  {}\n",
+                       instructions[function],
+                       100.0 * static_cast<double>(instructions[function]) / static_cast<double>(total),
+                       m_calls[function],
+                       m_functions[function]);
+    }
+
+    writeFile(filename, buffer);
+}
+
+void n2t::Profiler::writeFoldedStacks(const std::filesystem::path& filename)
+{
+    attribute();
+
+    fmt::memory_buffer buffer;
+    auto               out = std::back_inserter(buffer);
+
+    std::vector<uint32_t> path;
+    for (uint32_t node = 0; node < m_nodes.size(); ++node)
+    {
+        if (m_nodes[node].instructions == 0)
+        {
+            continue;
+        }
+
+        path.clear();
+        for (auto current = node; current != 0; current = m_nodes[current].parent)
+        {
+            path.push_back(current);
+        }
+        path.push_back(0);
+
+        for (auto iter = path.rbegin(); iter != path.rend(); ++iter)
+        {
+            fmt::format_to(out, "{}{}", (iter == path.rbegin()) ? "" : ";", m_functions[m_nodes[*iter].function]);
+        }
+        fmt::format_to(out, " {}\n", m_nodes[node].instructions);
+    }
+
+    writeFile(filename, buffer);
+}
+
+void n2t::Profiler::trackCall(uint16_t target, const uint16_t* ram)
+{
+    if (m_stack.back().returnAddress == target)
+    {
+        attribute();
+        m_stack.pop_back();
+        return;
+    }
+
+    // a VM 'call' sets LCL to SP just before jumping to the function, while a loop back to the entry point of a
+    // function without locals keeps the LCL of the function
+    const auto lcl = ram[lclAddress];
+    if ((lcl != ram[spAddress]) || (lcl < savedFrameSize) || (lcl == m_stack.back().lcl))
+    {
+        return;
+    }
+
+    attribute();
+
+    const auto function = m_functionAt[target];
+    ++m_calls[function];
+    m_stack.push_back(Frame{child(m_stack.back().node, function), ram[(lcl - savedFrameSize) & addressMask], lcl});
+}
+
+void n2t::Profiler::attribute()
+{
+    if (!m_stack.empty())
+    {
+        m_nodes[m_stack.back().node].instructions += m_instructions - m_attributed;
+    }
+    m_attributed = m_instructions;
+}
+
+uint32_t n2t::Profiler::child(uint32_t parent, uint32_t function)
+{
+    const auto key           = (uint64_t{parent} << 32) | function;
+    const auto [iter, added] = m_children.try_emplace(key, static_cast<uint32_t>(m_nodes.size()));
+    if (added)
+    {
+        m_nodes.push_back(Node{function, parent});
+    }
+    return iter->second;
+}
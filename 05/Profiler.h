@@ -0,0 +1,113 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef N2T_PROFILER_H
+#define N2T_PROFILER_H
+
+#include <SymbolMap.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace n2t
+{
+// Counts the instructions executed at each ROM address, and attributes them to the functions of a program
+// translated from VM code, whose entry points are the labels without a '$' in the symbol map of the program.
+//
+// The call stack is tracked from the jumps: a jump to a function entry point while LCL equals SP, and differs from
+// the LCL of the caller, is a VM 'call', whose return address is saved 5 words below LCL, and a jump to the return
+// address of the innermost call is the matching 'return'. The instructions executed between two calls or returns
+// are attributed to the current call stack, so that the profile of each call stack is exact.
+class Profiler
+{
+public:
+    explicit Profiler(const SymbolMap& symbols);
+
+    // Starts the call stack in the function containing 'pc'.
+    void start(uint16_t pc);
+
+    // Counts the instruction at 'pc', which is about to be executed.
+    void count(uint16_t pc)
+    {
+        ++m_counts[pc];
+        ++m_instructions;
+    }
+
+    // Tracks a jump to 'target', which has just been executed.
+    void jump(uint16_t target, const uint16_t* ram)
+    {
+        if (m_entries[target] || (m_stack.back().returnAddress == target))
+        {
+            trackCall(target, ram);
+        }
+    }
+
+    // Writes the instructions executed in each function, sorted by decreasing count, as a text table.
+    void writeFlatProfile(const std::filesystem::path& filename);
+
+    // Writes the instructions executed in each call stack, as 'function;function;... count' lines, the folded stack
+    // format of flame graph tools.
+    void writeFoldedStacks(const std::filesystem::path& filename);
+
+private:
+    // Node of the call tree: a function called along a given call stack.
+    struct Node
+    {
+        uint32_t function     = 0;
+        uint32_t parent       = 0;
+        uint64_t instructions = 0;
+    };
+
+    struct Frame
+    {
+        uint32_t node          = 0;
+        uint16_t returnAddress = 0;
+        uint16_t lcl           = 0;
+    };
+
+    void trackCall(uint16_t target, const uint16_t* ram);
+
+    // Attributes the instructions executed since the last call or return to the current call stack.
+    void attribute();
+
+    [[nodiscard]] uint32_t child(uint32_t parent, uint32_t function);
+
+    std::vector<std::string>               m_functions;
+    std::vector<uint32_t>                  m_functionAt;  // function containing each address
+    std::vector<bool>                      m_entries;     // whether each address is a function entry point
+    std::vector<uint64_t>                  m_counts;
+    std::vector<uint64_t>                  m_calls;
+    std::vector<Node>                      m_nodes;
+    std::unordered_map<uint64_t, uint32_t> m_children;
+    std::vector<Frame>                     m_stack;
+    uint64_t                               m_instructions = 0;
+    uint64_t                               m_attributed   = 0;
+};
+}  // namespace n2t
+
+#endif
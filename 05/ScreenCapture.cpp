@@ -0,0 +1,141 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ScreenCapture.h"
+
+#include <Util.h>
+
+#include <fmt/format.h>
+
+#include <bit>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace
+{
+// Reverses the bits of a byte: the Hack screen has the leftmost pixel of each word in its least significant bit.
+[[nodiscard]] constexpr uint8_t reverseBits(uint8_t value) noexcept
+{
+    uint8_t result = 0;
+    for (auto bit = 0; bit < 8; ++bit)
+    {
+        result = static_cast<uint8_t>((result << 1) | ((value >> bit) & 1));
+    }
+    return result;
+}
+
+template<typename Value>
+void writeLittleEndian(std::string& buffer, Value value)
+{
+    for (std::size_t byte = 0; byte < sizeof(Value); ++byte)
+    {
+        buffer.push_back(static_cast<char>(value >> (byte * 8)));
+    }
+}
+}  // namespace
+
+n2t::ScreenCapture::ScreenCapture(std::filesystem::path directory, FrameFormat format) :
+    m_directory{std::move(directory)}, m_format{format}
+{
+    std::filesystem::create_directories(m_directory);
+
+    if (m_format == FrameFormat::Raw)
+    {
+        const auto filename = m_directory / "frames.raw";
+        m_raw.open(filename, std::ios::binary);
+        throwUnless<std::runtime_error>(m_raw.good(), "Could not open output file ({})", filename.string());
+    }
+}
+
+bool n2t::ScreenCapture::capture(HackComputer& computer)
+{
+    const auto changes = computer.screenChanges();
+    const auto screen  = computer.ram().subspan(HackComputer::screenAddress, HackComputer::screenSize);
+
+    std::string record;
+    std::size_t count = 0;
+    for (std::size_t index = 0; index < changes.size(); ++index)
+    {
+        for (auto bits = changes[index]; bits != 0; bits &= bits - 1)
+        {
+            const auto offset = (index * 64) + static_cast<std::size_t>(std::countr_zero(bits));
+            const auto value  = screen[offset];
+
+            // a written word may keep its value
+            if (value == m_screen[offset])
+            {
+                continue;
+            }
+            m_screen[offset] = value;
+            ++count;
+
+            if (m_format == FrameFormat::Raw)
+            {
+                writeLittleEndian(record, static_cast<uint16_t>(offset));
+                writeLittleEndian(record, value);
+            }
+            else
+            {
+                m_image[offset * 2]       = reverseBits(static_cast<uint8_t>(value));
+                m_image[(offset * 2) + 1] = reverseBits(static_cast<uint8_t>(value >> 8));
+            }
+        }
+    }
+    computer.clearScreenChanges();
+
+    if (count == 0)
+    {
+        return false;
+    }
+
+    if (m_format == FrameFormat::Raw)
+    {
+        std::string header;
+        writeLittleEndian(header, computer.cycles());
+        writeLittleEndian(header, static_cast<uint16_t>(count));
+        m_raw.write(header.data(), static_cast<std::streamsize>(header.size()));
+        m_raw.write(record.data(), static_cast<std::streamsize>(record.size()));
+        throwUnless<std::runtime_error>(m_raw.good(), "Could not write output file (frames.raw)");
+    }
+    else
+    {
+        writePbm(computer.cycles());
+    }
+
+    ++m_frames;
+    return true;
+}
+
+void n2t::ScreenCapture::writePbm(uint64_t cycles)
+{
+    const auto filename = m_directory / fmt::format("frame-{:06}.pbm", m_frames);
+
+    std::ofstream file{filename, std::ios::binary};
+    throwUnless<std::runtime_error>(file.good(), "Could not open output file ({})", filename.string());
+
+    file << fmt::format("P4\n# cycle {}\n{} {}\n", cycles, screenWidth, screenHeight);
+    file.write(reinterpret_cast<const char*>(m_image.data()), static_cast<std::streamsize>(m_image.size()));
+    throwUnless<std::runtime_error>(file.good(), "Could not write output file ({})", filename.string());
+}
@@ -0,0 +1,91 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef N2T_SCREEN_CAPTURE_H
+#define N2T_SCREEN_CAPTURE_H
+
+#include "HackComputer.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+
+namespace n2t
+{
+enum class FrameFormat
+{
+    Pbm,  // one binary PBM image per frame
+    Raw,  // a single stream with the changed screen words of each frame
+};
+
+// Writes frames of the screen of a Hack computer into a directory. Only the screen words written by the program since
+// the previous frame are compared with the previous frame, and a frame is written only if one of them changed.
+//
+// PBM frames are named 'frame-NNNNNN.pbm' after their index, and record the cycle count of the computer in a comment.
+// The raw stream 'frames.raw' contains, for each frame, the cycle count (64 bits), the number of changed words
+// (16 bits), and the offset in the screen memory map and the value of each changed word (16 bits each), all in
+// little-endian byte order.
+class ScreenCapture
+{
+public:
+    static constexpr std::size_t screenWidth  = 512;
+    static constexpr std::size_t screenHeight = 256;
+
+    ScreenCapture(std::filesystem::path directory, FrameFormat format);
+
+    ScreenCapture(const ScreenCapture&) = delete;
+    ScreenCapture(ScreenCapture&&)      = delete;
+
+    ScreenCapture& operator=(const ScreenCapture&) = delete;
+    ScreenCapture& operator=(ScreenCapture&&) = delete;
+
+    ~ScreenCapture() = default;
+
+    // Writes a frame if the screen changed since the previous frame, clears the changes, and returns whether a frame
+    // was written.
+    bool capture(HackComputer& computer);
+
+    [[nodiscard]] std::size_t frames() const
+    {
+        return m_frames;
+    }
+
+private:
+    void writePbm(uint64_t cycles);
+
+    std::filesystem::path m_directory;
+    FrameFormat           m_format;
+    std::ofstream         m_raw;
+    std::size_t           m_frames = 0;
+
+    // screen memory map of the previous frame, and its image in the PBM layout: rows of bytes, with the leftmost
+    // pixel in the most significant bit
+    std::array<uint16_t, HackComputer::screenSize>      m_screen = {};
+    std::array<uint8_t, screenWidth * screenHeight / 8> m_image  = {};
+};
+}  // namespace n2t
+
+#endif
@@ -0,0 +1,199 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Snapshot.h"
+
+#include <MappedFile.h>
+#include <Util.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace
+{
+constexpr std::string_view signature = "N2TS";
+constexpr uint16_t         version   = 1;
+
+// Number of zero words between two nonzero words below which they are saved in the same block, as a new block
+// costs its address and its length.
+constexpr std::size_t minimumGap = 3;
+
+// Returns the 64-bit FNV-1a hash of the words of the program.
+[[nodiscard]] uint64_t hashProgram(std::span<const uint16_t> rom) noexcept
+{
+    auto hash = uint64_t{0xCBF29CE484222325};
+    for (const auto word : rom)
+    {
+        for (const auto byte : {word & 0xFF, word >> 8})
+        {
+            hash = (hash ^ static_cast<uint64_t>(byte)) * 0x100000001B3;
+        }
+    }
+    return hash;
+}
+
+template<typename Value>
+void writeLittleEndian(std::string& buffer, Value value)
+{
+    for (std::size_t byte = 0; byte < sizeof(Value); ++byte)
+    {
+        buffer.push_back(static_cast<char>(value >> (byte * 8)));
+    }
+}
+
+// Reads the values of a snapshot, and throws if the snapshot is truncated.
+class SnapshotReader
+{
+public:
+    SnapshotReader(std::string_view contents, const std::filesystem::path& filename) :
+        m_contents{contents}, m_filename{filename}
+    {
+    }
+
+    template<typename Value>
+    [[nodiscard]] Value read()
+    {
+        n2t::throwUnless<std::runtime_error>(m_offset + sizeof(Value) <= m_contents.size(),
+                                             "Truncated snapshot file ({})",
+                                             m_filename.string());
+
+        auto value = Value{0};
+        for (std::size_t byte = 0; byte < sizeof(Value); ++byte)
+        {
+            value |= static_cast<Value>(static_cast<Value>(static_cast<uint8_t>(m_contents[m_offset++])) << (byte * 8));
+        }
+        return value;
+    }
+
+    [[nodiscard]] bool atEnd() const noexcept
+    {
+        return m_offset == m_contents.size();
+    }
+
+private:
+    std::string_view             m_contents;
+    const std::filesystem::path& m_filename;
+    std::size_t                  m_offset = 0;
+};
+}  // namespace
+
+void n2t::saveSnapshot(const std::filesystem::path& filename, const HackComputer& computer)
+{
+    std::string buffer{signature};
+    writeLittleEndian(buffer, version);
+    writeLittleEndian(buffer, hashProgram(computer.rom()));
+    writeLittleEndian(buffer, computer.cycles());
+    writeLittleEndian(buffer, computer.a());
+    writeLittleEndian(buffer, computer.d());
+    writeLittleEndian(buffer, computer.pc());
+    writeLittleEndian(buffer, static_cast<uint8_t>(computer.halted() ? 1 : 0));
+
+    // blocks of nonzero words, merged across short runs of zero words
+    const auto                                       ram = computer.ram();
+    std::vector<std::pair<std::size_t, std::size_t>> blocks;
+    for (std::size_t address = 0; address < ram.size(); ++address)
+    {
+        if (ram[address] == 0)
+        {
+            continue;
+        }
+        if (!blocks.empty() && (address - blocks.back().second <= minimumGap))
+        {
+            blocks.back().second = address + 1;
+        }
+        else
+        {
+            blocks.emplace_back(address, address + 1);
+        }
+    }
+
+    writeLittleEndian(buffer, static_cast<uint16_t>(blocks.size()));
+    for (const auto& [first, end] : blocks)
+    {
+        writeLittleEndian(buffer, static_cast<uint16_t>(first));
+        writeLittleEndian(buffer, static_cast<uint16_t>(end - first));
+        for (auto address = first; address < end; ++address)
+        {
+            writeLittleEndian(buffer, ram[address]);
+        }
+    }
+
+    std::ofstream file{filename, std::ios::binary};
+    throwUnless<std::runtime_error>(file.good(), "Could not open output file ({})", filename.string());
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    throwUnless<std::runtime_error>(file.good(), "Could not write output file ({})", filename.string());
+}
+
+void n2t::loadSnapshot(const std::filesystem::path& filename, HackComputer& computer)
+{
+    const MappedFile file{filename};
+    const auto       contents = file.contents();
+
+    throwUnless<std::runtime_error>(contents.starts_with(signature), "Invalid snapshot file ({})", filename.string());
+
+    SnapshotReader reader{contents.substr(signature.size()), filename};
+
+    const auto fileVersion = reader.read<uint16_t>();
+    throwUnless<std::runtime_error>(fileVersion == version,
+                                    "Unsupported snapshot version ({}) in file ({})",
+                                    fileVersion,
+                                    filename.string());
+    throwUnless<std::runtime_error>(reader.read<uint64_t>() == hashProgram(computer.rom()),
+                                    "Snapshot file ({}) was taken from another program",
+                                    filename.string());
+
+    const auto cycles = reader.read<uint64_t>();
+    const auto a      = reader.read<uint16_t>();
+    const auto d      = reader.read<uint16_t>();
+    const auto pc     = reader.read<uint16_t>();
+    const auto halted = reader.read<uint8_t>() != 0;
+
+    auto ram = computer.ram();
+    std::fill(ram.begin(), ram.end(), uint16_t{0});
+
+    const auto blocks = reader.read<uint16_t>();
+    for (uint16_t block = 0; block < blocks; ++block)
+    {
+        const std::size_t first  = reader.read<uint16_t>();
+        const std::size_t length = reader.read<uint16_t>();
+        throwUnless<std::runtime_error>(first + length <= ram.size(),
+                                        "Invalid memory block in snapshot file ({})",
+                                        filename.string());
+        for (auto address = first; address < first + length; ++address)
+        {
+            ram[address] = reader.read<uint16_t>();
+        }
+    }
+    throwUnless<std::runtime_error>(reader.atEnd(), "Invalid snapshot file ({})", filename.string());
+
+    computer.restore(a, d, pc, cycles, halted);
+}
@@ -0,0 +1,50 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef N2T_SNAPSHOT_H
+#define N2T_SNAPSHOT_H
+
+#include "HackComputer.h"
+
+#include <filesystem>
+
+namespace n2t
+{
+// A snapshot saves the registers, the cycle count and the data memory of a Hack computer, so that a program can be
+// resumed from a point it reaches after a long initialization, such as the entry of 'Main.main' after the OS
+// initialization of a Jack program.
+//
+// The binary format starts with the signature 'N2TS', the format version (16 bits), a hash of the program (64 bits),
+// the cycle count (64 bits), the A, D and PC registers (16 bits each) and the halted flag (8 bits). The data memory
+// follows as a number of blocks (16 bits) and, for each block of nonzero words, its address, its length and its
+// words (16 bits each). The words outside the blocks are zero. All values are in little-endian byte order.
+
+// Saves a snapshot of the computer to the given file.
+void saveSnapshot(const std::filesystem::path& filename, const HackComputer& computer);
+
+// Loads a snapshot from the given file into the computer, which must run the program the snapshot was taken from.
+void loadSnapshot(const std::filesystem::path& filename, HackComputer& computer);
+}  // namespace n2t
+
+#endif
@@ -0,0 +1,202 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "TestFarm.h"
+
+#include <Util.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace
+{
+// Escapes the characters of a text which have a meaning in XML.
+[[nodiscard]] std::string escapeXml(std::string_view text)
+{
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (const auto c : text)
+    {
+        switch (c)
+        {
+            case '&':
+                escaped.append("&amp;");
+                break;
+            case '<':
+                escaped.append("&lt;");
+                break;
+            case '>':
+                escaped.append("&gt;");
+                break;
+            case '"':
+                escaped.append("&quot;");
+                break;
+            default:
+                escaped.push_back(c);
+                break;
+        }
+    }
+    return escaped;
+}
+}  // namespace
+
+n2t::TestFarm::TestFarm(std::vector<std::filesystem::path> filenames, unsigned int numThreads) :
+    m_queues(std::clamp<std::size_t>(numThreads, 1, std::max<std::size_t>(filenames.size(), 1)))
+{
+    m_tests.reserve(filenames.size());
+    for (auto& filename : filenames)
+    {
+        auto& test    = m_tests.emplace_back();
+        test.filename = std::move(filename);
+    }
+
+    // contiguous ranges of tests, whose sizes differ by at most one
+    for (std::size_t test = 0; test < m_tests.size(); ++test)
+    {
+        m_queues[test * m_queues.size() / m_tests.size()].tests.push_back(test);
+    }
+}
+
+void n2t::TestFarm::run(const TestOptions& options, const std::function<void(const TestCase&)>& report)
+{
+    std::vector<std::future<void>> futures;
+    futures.reserve(m_queues.size() - 1);
+    for (std::size_t worker = 1; worker < m_queues.size(); ++worker)
+    {
+        futures.push_back(
+            std::async(std::launch::async, [this, worker, &options, &report] { runWorker(worker, options, report); }));
+    }
+    runWorker(0, options, report);
+    for (auto& future : futures)
+    {
+        future.get();
+    }
+}
+
+void n2t::TestFarm::writeJUnitReport(const std::filesystem::path& filename, double seconds) const
+{
+    const auto failures = std::count_if(m_tests.begin(), m_tests.end(), [](const TestCase& test) {
+        return test.error.empty() && !test.result.passed;
+    });
+    const auto errors = std::count_if(m_tests.begin(), m_tests.end(), [](const TestCase& test) {
+        return !test.error.empty();
+    });
+
+    std::string report = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    report.append(fmt::format("<testsuites tests=\"{}\" failures=\"{}\" errors=\"{}\" time=\"{:.3f}\">\n",
+                              m_tests.size(),
+                              failures,
+                              errors,
+                              seconds));
+    report.append(
+        fmt::format("  <testsuite name=\"HackTester\" tests=\"{}\" failures=\"{}\" errors=\"{}\" time=\"{:.3f}\">\n",
+                    m_tests.size(),
+                    failures,
+                    errors,
+                    seconds));
+    for (const auto& test : m_tests)
+    {
+        // the directory of a script names its class, as in the nand2tetris projects
+        report.append(fmt::format("    <testcase classname=\"{}\" name=\"{}\" time=\"{:.3f}\"",
+                                  escapeXml(test.filename.parent_path().generic_string()),
+                                  escapeXml(test.filename.stem().string()),
+                                  test.seconds));
+        if (!test.error.empty())
+        {
+            report.append(fmt::format(">\n      <error message=\"{}\"/>\n    </testcase>\n", escapeXml(test.error)));
+        }
+        else if (!test.result.passed)
+        {
+            report.append(fmt::format(">\n      <failure message=\"{}\"/>\n    </testcase>\n",
+                                      escapeXml(test.result.message)));
+        }
+        else
+        {
+            report.append("/>\n");
+        }
+    }
+    report.append("  </testsuite>\n</testsuites>\n");
+
+    std::ofstream file{filename, std::ios::binary};
+    throwUnless<std::runtime_error>(file.good(), "Could not open output file ({})", filename.string());
+    file.write(report.data(), static_cast<std::streamsize>(report.size()));
+    throwUnless<std::runtime_error>(file.good(), "Could not write output file ({})", filename.string());
+}
+
+void n2t::TestFarm::runWorker(std::size_t                                  worker,
+                              const TestOptions&                           options,
+                              const std::function<void(const TestCase&)>& report)
+{
+    std::size_t index = 0;
+    while (takeTest(worker, index))
+    {
+        auto&      test      = m_tests[index];
+        const auto startTime = std::chrono::steady_clock::now();
+        try
+        {
+            test.result = TestScript{test.filename}.run(options);
+        }
+        catch (const std::exception& ex)
+        {
+            test.error = ex.what();
+        }
+        test.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        const std::lock_guard<std::mutex> lock{m_reportMutex};
+        report(test);
+    }
+}
+
+bool n2t::TestFarm::takeTest(std::size_t worker, std::size_t& test)
+{
+    for (std::size_t offset = 0; offset < m_queues.size(); ++offset)
+    {
+        auto&                             queue = m_queues[(worker + offset) % m_queues.size()];
+        const std::lock_guard<std::mutex> lock{queue.mutex};
+        if (queue.tests.empty())
+        {
+            continue;
+        }
+
+        if (offset == 0)
+        {
+            test = queue.tests.back();
+            queue.tests.pop_back();
+        }
+        else
+        {
+            test = queue.tests.front();
+            queue.tests.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,95 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef N2T_TEST_FARM_H
+#define N2T_TEST_FARM_H
+
+#include "TestScript.h"
+
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace n2t
+{
+struct TestCase
+{
+    std::filesystem::path filename;
+    TestResult            result;
+    std::string           error;  // the error that prevented the script from running, if any
+    double                seconds = 0.0;
+};
+
+// Runs test scripts on a pool of threads. Each thread starts with a contiguous range of the scripts in its own queue,
+// and takes the scripts from the back of its queue. A thread whose queue is empty steals the scripts from the front
+// of the queues of the other threads, so that the threads which get the long tests do not delay the others.
+class TestFarm
+{
+public:
+    TestFarm(std::vector<std::filesystem::path> filenames, unsigned int numThreads);
+
+    TestFarm(const TestFarm&) = delete;
+    TestFarm(TestFarm&&)      = delete;
+
+    TestFarm& operator=(const TestFarm&) = delete;
+    TestFarm& operator=(TestFarm&&) = delete;
+
+    ~TestFarm() = default;
+
+    // Runs all the tests, and calls 'report' with each test as soon as it is done. The calls to 'report' are
+    // serialized, while tests() keeps the order of the filenames.
+    void run(const TestOptions& options, const std::function<void(const TestCase&)>& report);
+
+    [[nodiscard]] const std::vector<TestCase>& tests() const
+    {
+        return m_tests;
+    }
+
+    // Writes the results of the tests as a JUnit XML report, the format read by continuous integration servers.
+    void writeJUnitReport(const std::filesystem::path& filename, double seconds) const;
+
+private:
+    struct Queue
+    {
+        std::mutex              mutex;
+        std::deque<std::size_t> tests;
+    };
+
+    void runWorker(std::size_t worker, const TestOptions& options, const std::function<void(const TestCase&)>& report);
+
+    // Takes a test from the back of the queue of the worker, or steals one from the front of another queue, and
+    // returns false when all the queues are empty.
+    [[nodiscard]] bool takeTest(std::size_t worker, std::size_t& test);
+
+    std::vector<TestCase> m_tests;
+    std::vector<Queue>    m_queues;
+    std::mutex            m_reportMutex;
+};
+}  // namespace n2t
+
+#endif
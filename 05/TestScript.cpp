@@ -0,0 +1,790 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "TestScript.h"
+
+#include <AssemblyEngine.h>
+#include <MappedFile.h>
+#include <RomImage.h>
+#include <Util.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace
+{
+struct Token
+{
+    std::string_view text;
+    unsigned int     lineNumber = 0;
+    bool             quoted     = false;
+};
+
+// Number of cycles or loop iterations between two checks of the deadline of a test with a timeout.
+constexpr uint64_t deadlineCheckCycles = 0x10000;
+
+// Failure of a test, which stops its execution.
+class TestFailure : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+[[nodiscard]] bool isSeparator(char c) noexcept
+{
+    return (c == ',') || (c == ';') || (c == '!') || (c == '{') || (c == '}');
+}
+
+[[nodiscard]] bool isTerminator(const Token& token) noexcept
+{
+    return !token.quoted && ((token.text == ",") || (token.text == ";") || (token.text == "!"));
+}
+
+// Splits a script into words, quoted strings and separators, skipping the '//' and '/* */' comments.
+[[nodiscard]] std::vector<Token> tokenize(std::string_view contents, std::string_view name)
+{
+    std::vector<Token> tokens;
+    unsigned int       lineNumber = 1;
+
+    std::size_t index = 0;
+    while (index < contents.size())
+    {
+        const auto c = contents[index];
+        if (c == '\n')
+        {
+            ++lineNumber;
+            ++index;
+        }
+        else if ((c == ' ') || (c == '\t') || (c == '\r'))
+        {
+            ++index;
+        }
+        else if (contents.substr(index, 2) == "//")
+        {
+            index = std::min(contents.find('\n', index), contents.size());
+        }
+        else if (contents.substr(index, 2) == "/*")
+        {
+            const auto end = contents.find("*/", index + 2);
+            n2t::throwUnless(end != std::string_view::npos, {name, lineNumber}, "Unterminated comment");
+            lineNumber += static_cast<unsigned int>(std::count(&contents[index], &contents[end], '\n'));
+            index = end + 2;
+        }
+        else if (c == '"')
+        {
+            const auto end = contents.find('"', index + 1);
+            n2t::throwUnless(end != std::string_view::npos, {name, lineNumber}, "Unterminated string");
+            tokens.push_back(Token{contents.substr(index + 1, end - index - 1), lineNumber, true});
+            index = end + 1;
+        }
+        else if (isSeparator(c))
+        {
+            tokens.push_back(Token{contents.substr(index, 1), lineNumber});
+            ++index;
+        }
+        else
+        {
+            auto end = index;
+            while ((end < contents.size()) && !isSeparator(contents[end]) && (contents[end] != '"') &&
+                   (contents[end] != ' ') && (contents[end] != '\t') && (contents[end] != '\r') &&
+                   (contents[end] != '\n'))
+            {
+                ++end;
+            }
+            tokens.push_back(Token{contents.substr(index, end - index), lineNumber});
+            index = end;
+        }
+    }
+
+    return tokens;
+}
+
+template<typename Value>
+[[nodiscard]] bool parseNumber(std::string_view text, Value& value, int base = 10)
+{
+    const auto result = std::from_chars(text.data(), text.data() + text.size(), value, base);
+    return (result.ec == std::errc{}) && (result.ptr == (text.data() + text.size())) && !text.empty();
+}
+
+// Parses a 16-bit value, in decimal or with a '%B', '%X' or '%D' prefix.
+[[nodiscard]] bool parseValue(std::string_view text, int32_t& value)
+{
+    auto base = 10;
+    if ((text.size() >= 2) && (text[0] == '%'))
+    {
+        switch (text[1])
+        {
+            case 'B':
+                base = 2;
+                break;
+            case 'X':
+                base = 16;
+                break;
+            case 'D':
+                break;
+            default:
+                return false;
+        }
+        text.remove_prefix(2);
+    }
+    return parseNumber(text, value, base) && (value >= -32768) && (value <= 65535);
+}
+
+// Returns whether an output line matches a line of the compare file, where '*' matches any character.
+[[nodiscard]] bool matches(std::string_view line, std::string_view expected)
+{
+    while (!expected.empty() && ((expected.back() == ' ') || (expected.back() == '\t') || (expected.back() == '\r')))
+    {
+        expected.remove_suffix(1);
+    }
+    while (!line.empty() && (line.back() == ' '))
+    {
+        line.remove_suffix(1);
+    }
+
+    return (line.size() == expected.size()) &&
+           std::equal(line.begin(), line.end(), expected.begin(), [](char actual, char pattern) {
+               return (pattern == '*') || (actual == pattern);
+           });
+}
+}  // namespace
+
+// State of a running script.
+class n2t::TestScript::Execution
+{
+public:
+    Execution(const TestScript& script, const TestOptions& options, TestResult& result) :
+        m_script{script}, m_options{options}, m_result{result}
+    {
+        if (m_options.timeout.count() > 0)
+        {
+            m_deadline = std::chrono::steady_clock::now() + m_options.timeout;
+        }
+    }
+
+    void execute(std::size_t first, std::size_t last);
+
+private:
+    [[nodiscard]] HackComputer& computer();
+    [[nodiscard]] int64_t       read(const Variable& variable) const;
+    [[nodiscard]] bool          test(const Command& command);
+
+    void load(const Command& command);
+    void set(const Command& command);
+    void advance(uint64_t cycles);
+    void checkDeadline(uint64_t cycles);
+    void writeLine(const std::string& line);
+    void writeHeader();
+    void writeValues();
+
+    const TestScript&           m_script;
+    const TestOptions&          m_options;
+    TestResult&                 m_result;
+    std::optional<HackComputer> m_computer;
+    std::ofstream               m_output;
+    std::vector<std::string>    m_compareLines;
+    bool                        m_compare = false;
+    const std::vector<Column>*  m_columns = nullptr;
+
+    std::optional<std::chrono::steady_clock::time_point> m_deadline;
+    uint64_t                                             m_uncheckedCycles = 0;
+};
+
+n2t::TestScript::TestScript(std::filesystem::path filename) : m_filename{std::move(filename)}
+{
+    const MappedFile file{m_filename};
+    const auto       name   = m_filename.filename().string();
+    const auto       tokens = tokenize(file.contents(), name);
+
+    // indices of the loop commands whose body is being parsed
+    std::vector<std::size_t> loops;
+
+    std::size_t index = 0;
+    const auto  next  = [&](std::string_view what) -> const Token& {
+        throwUnless(index < tokens.size(),
+                    {name, tokens.empty() ? 0 : tokens.back().lineNumber},
+                    "Missing {} at the end of the script",
+                    what);
+        return tokens[index++];
+    };
+
+    while (index < tokens.size())
+    {
+        const auto& token = next("command");
+        const auto  where = SourceLocation{name, token.lineNumber};
+
+        if (token.text == "}")
+        {
+            throwUnless(!loops.empty(), where, "Unexpected '}}'");
+            m_commands[loops.back()].bodyEnd = m_commands.size();
+            loops.pop_back();
+
+            // a loop may be followed by a terminator
+            if ((index < tokens.size()) && isTerminator(tokens[index]))
+            {
+                ++index;
+            }
+            continue;
+        }
+        throwUnless(!token.quoted && !isSeparator(token.text.front()), where, "Invalid command ({})", token.text);
+
+        const auto parseVariable = [&](std::string_view text) {
+            Variable variable;
+            if (text == "A")
+            {
+                variable.kind = VariableKind::A;
+            }
+            else if (text == "D")
+            {
+                variable.kind = VariableKind::D;
+            }
+            else if (text == "PC")
+            {
+                variable.kind = VariableKind::PC;
+            }
+            else if (text == "time")
+            {
+                variable.kind = VariableKind::Time;
+            }
+            else
+            {
+                throwUnless(text.starts_with("RAM[") && text.ends_with("]") &&
+                                parseNumber(text.substr(4, text.size() - 5), variable.address) &&
+                                (variable.address < HackComputer::ramSize),
+                            where,
+                            "Invalid variable ({})",
+                            text);
+                variable.kind = VariableKind::Ram;
+            }
+            return variable;
+        };
+
+        Command command;
+        if ((token.text == "load") || (token.text == "output-file") || (token.text == "compare-to"))
+        {
+            command.kind = (token.text == "load")          ? CommandKind::Load
+                           : (token.text == "output-file") ? CommandKind::OutputFile
+                                                           : CommandKind::CompareTo;
+            const auto& argument = next("file name");
+            throwUnless(!isTerminator(argument), where, "Missing file name of command ({})", token.text);
+            command.text = argument.text;
+        }
+        else if (token.text == "output-list")
+        {
+            command.kind = CommandKind::OutputList;
+            while ((index < tokens.size()) && !isTerminator(tokens[index]))
+            {
+                const auto text    = next("column").text;
+                const auto percent = std::min(text.find('%'), text.size());
+
+                Column column;
+                column.name     = text.substr(0, percent);
+                column.variable = parseVariable(column.name);
+                if (percent != text.size())
+                {
+                    // %<format><left>.<width>.<right>
+                    const auto spec   = text.substr(percent + 1);
+                    const auto first  = spec.find('.');
+                    const auto second = spec.find('.', first + 1);
+                    throwUnless(!spec.empty() && (std::string_view{"BDXS"}.find(spec[0]) != std::string_view::npos) &&
+                                    (second != std::string_view::npos) &&
+                                    parseNumber(spec.substr(1, first - 1), column.padLeft) &&
+                                    parseNumber(spec.substr(first + 1, second - first - 1), column.width) &&
+                                    parseNumber(spec.substr(second + 1), column.padRight),
+                                where,
+                                "Invalid output format ({})",
+                                text);
+                    column.format = spec[0];
+                }
+                command.columns.push_back(std::move(column));
+            }
+            throwUnless(!command.columns.empty(), where, "Empty output list");
+        }
+        else if (token.text == "set")
+        {
+            command.kind     = CommandKind::Set;
+            command.variable = parseVariable(next("variable").text);
+            throwUnless(command.variable.kind != VariableKind::Time, where, "Variable (time) cannot be set");
+
+            const auto& value = next("value");
+            throwUnless(parseValue(value.text, command.value), where, "Invalid value ({})", value.text);
+        }
+        else if ((token.text == "repeat") || (token.text == "while"))
+        {
+            if (token.text == "repeat")
+            {
+                // without a count, the loop repeats until the cycle limit
+                command.kind = CommandKind::Repeat;
+                if ((index < tokens.size()) && (tokens[index].text != "{"))
+                {
+                    const auto& count = next("count");
+                    throwUnless(parseNumber(count.text, command.value) && (command.value > 0),
+                                where,
+                                "Invalid repeat count ({})",
+                                count.text);
+                }
+            }
+            else
+            {
+                // while <variable> <comparison> <value>
+                command.kind     = CommandKind::While;
+                command.variable = parseVariable(next("variable").text);
+
+                const auto comparison = next("comparison").text;
+                if (comparison == "=")
+                {
+                    command.comparison = Comparison::Equal;
+                }
+                else if (comparison == "<>")
+                {
+                    command.comparison = Comparison::NotEqual;
+                }
+                else if (comparison == "<")
+                {
+                    command.comparison = Comparison::Less;
+                }
+                else if (comparison == ">")
+                {
+                    command.comparison = Comparison::Greater;
+                }
+                else if (comparison == "<=")
+                {
+                    command.comparison = Comparison::LessOrEqual;
+                }
+                else
+                {
+                    throwUnless(comparison == ">=", where, "Invalid comparison ({})", comparison);
+                    command.comparison = Comparison::GreaterOrEqual;
+                }
+
+                const auto& value = next("value");
+                throwUnless(parseValue(value.text, command.value), where, "Invalid value ({})", value.text);
+            }
+
+            throwUnless(next("'{'").text == "{", where, "Missing '{{' after command ({})", token.text);
+            loops.push_back(m_commands.size());
+            m_commands.push_back(std::move(command));
+            continue;
+        }
+        else if (token.text == "ticktock")
+        {
+            command.kind = CommandKind::TickTock;
+        }
+        else if (token.text == "tick")
+        {
+            command.kind = CommandKind::Tick;
+        }
+        else if (token.text == "tock")
+        {
+            command.kind = CommandKind::Tock;
+        }
+        else if (token.text == "output")
+        {
+            command.kind = CommandKind::Output;
+        }
+        else if (token.text == "echo")
+        {
+            command.kind = CommandKind::Echo;
+            command.text = next("message").text;
+        }
+        else if (token.text == "clear-echo")
+        {
+            command.kind = CommandKind::ClearEcho;
+        }
+        else
+        {
+            throwAlways(where, "Unsupported command ({})", token.text);
+        }
+
+        const auto& terminator = next("terminator");
+        throwUnless(isTerminator(terminator),
+                    {name, terminator.lineNumber},
+                    "Missing ',' or ';' after command ({})",
+                    token.text);
+        m_commands.push_back(std::move(command));
+    }
+    throwUnless(loops.empty(), {name, tokens.empty() ? 0 : tokens.back().lineNumber}, "Missing '}}'");
+
+    // the 'repeat' loops that only run the clock are executed in a single run of the emulator
+    for (auto& command : m_commands)
+    {
+        if (command.kind == CommandKind::Repeat)
+        {
+            const auto* first = &command + 1;
+            const auto* last  = m_commands.data() + command.bodyEnd;
+            if ((first != last) && std::all_of(first, last, [](const Command& bodyCommand) {
+                    return bodyCommand.kind == CommandKind::TickTock;
+                }))
+            {
+                command.ticks = static_cast<uint64_t>(last - first);
+            }
+        }
+    }
+}
+
+n2t::TestResult n2t::TestScript::run(const TestOptions& options) const
+{
+    TestResult result;
+    Execution  execution{*this, options, result};
+    try
+    {
+        execution.execute(0, m_commands.size());
+        result.passed  = true;
+        result.message = (result.comparedLines != 0) ? "End of script - Comparison ended successfully"
+                                                     : "End of script";
+    }
+    catch (const TestFailure& failure)
+    {
+        result.message = failure.what();
+    }
+    return result;
+}
+
+void n2t::TestScript::Execution::execute(std::size_t first, std::size_t last)
+{
+    for (auto index = first; index < last; ++index)
+    {
+        const auto& command = m_script.m_commands[index];
+        switch (command.kind)
+        {
+            case CommandKind::Load:
+                load(command);
+                break;
+
+            case CommandKind::OutputFile:
+            {
+                const auto filename = m_script.m_filename.parent_path() / command.text;
+                m_output.close();
+                m_output.open(filename);
+                throwUnless<std::runtime_error>(m_output.good(), "Could not open output file ({})", filename.string());
+                break;
+            }
+
+            case CommandKind::CompareTo:
+            {
+                const MappedFile file{m_script.m_filename.parent_path() / command.text};
+                auto             contents = file.contents();
+
+                m_compareLines.clear();
+                while (!contents.empty())
+                {
+                    const auto lineEnd = std::min(contents.find('\n'), contents.size());
+                    m_compareLines.emplace_back(contents.substr(0, lineEnd));
+                    contents.remove_prefix(std::min(lineEnd + 1, contents.size()));
+                }
+                m_compare = true;
+                break;
+            }
+
+            case CommandKind::OutputList:
+                m_columns = &command.columns;
+                writeHeader();
+                break;
+
+            case CommandKind::Set:
+                set(command);
+                break;
+
+            case CommandKind::Repeat:
+            case CommandKind::While:
+            {
+                const auto bodyFirst = index + 1;
+                const auto bodyLast  = command.bodyEnd;
+                if (command.kind == CommandKind::Repeat)
+                {
+                    if (command.ticks != 0)
+                    {
+                        // a loop without a count runs until the cycle limit
+                        const auto iterations = (command.value != 0) ? static_cast<uint64_t>(command.value)
+                                                                     : std::numeric_limits<uint64_t>::max();
+                        advance((iterations > std::numeric_limits<uint64_t>::max() / command.ticks)
+                                    ? std::numeric_limits<uint64_t>::max()
+                                    : iterations * command.ticks);
+                    }
+                    else
+                    {
+                        for (int32_t iteration = 0; (command.value == 0) || (iteration < command.value); ++iteration)
+                        {
+                            execute(bodyFirst, bodyLast);
+                            checkDeadline(1);
+                        }
+                    }
+                }
+                else
+                {
+                    while (test(command))
+                    {
+                        execute(bodyFirst, bodyLast);
+                        checkDeadline(1);
+                    }
+                }
+                index = bodyLast - 1;
+                break;
+            }
+
+            case CommandKind::TickTock:
+            case CommandKind::Tock:
+                advance(1);
+                break;
+
+            case CommandKind::Tick:
+                // the instruction is executed on the falling edge of the clock
+                break;
+
+            case CommandKind::Output:
+                writeValues();
+                break;
+
+            case CommandKind::Echo:
+                m_result.echoes.push_back(command.text);
+                break;
+
+            case CommandKind::ClearEcho:
+                break;
+        }
+    }
+}
+
+n2t::HackComputer& n2t::TestScript::Execution::computer()
+{
+    throwUnless(m_computer.has_value(),
+                "Script ({}) runs the clock or sets a variable before command (load)",
+                m_script.m_filename.filename().string());
+    return *m_computer;
+}
+
+int64_t n2t::TestScript::Execution::read(const Variable& variable) const
+{
+    if (variable.kind == VariableKind::Time)
+    {
+        return m_computer ? static_cast<int64_t>(m_computer->cycles()) : 0;
+    }
+    if (!m_computer)
+    {
+        return 0;
+    }
+
+    switch (variable.kind)
+    {
+        case VariableKind::A:
+            return static_cast<int16_t>(m_computer->a());
+        case VariableKind::D:
+            return static_cast<int16_t>(m_computer->d());
+        case VariableKind::PC:
+            return m_computer->pc();
+        default:
+            return static_cast<int16_t>(m_computer->ram()[variable.address]);
+    }
+}
+
+bool n2t::TestScript::Execution::test(const Command& command)
+{
+    const auto value    = read(command.variable);
+    const auto expected = (command.variable.kind == VariableKind::Time)
+                              ? int64_t{command.value}
+                              : int64_t{static_cast<int16_t>(static_cast<uint16_t>(command.value))};
+    switch (command.comparison)
+    {
+        case Comparison::Equal:
+            return value == expected;
+        case Comparison::NotEqual:
+            return value != expected;
+        case Comparison::Less:
+            return value < expected;
+        case Comparison::Greater:
+            return value > expected;
+        case Comparison::LessOrEqual:
+            return value <= expected;
+        default:
+            return value >= expected;
+    }
+}
+
+void n2t::TestScript::Execution::load(const Command& command)
+{
+    const auto filename = m_script.m_filename.parent_path() / command.text;
+
+    RomImage rom;
+    if (filename.extension() == ".asm")
+    {
+        const MappedFile file{filename};
+        rom = AssemblyEngine::assembleText(file.contents(), filename.filename().string());
+    }
+    else
+    {
+        rom = loadRomImage(filename);
+    }
+    m_computer.emplace(std::move(rom), m_options.engine);
+}
+
+void n2t::TestScript::Execution::set(const Command& command)
+{
+    auto&      target = computer();
+    const auto value  = static_cast<uint16_t>(command.value);
+
+    auto a  = target.a();
+    auto d  = target.d();
+    auto pc = target.pc();
+    switch (command.variable.kind)
+    {
+        case VariableKind::A:
+            a = value;
+            break;
+        case VariableKind::D:
+            d = value;
+            break;
+        case VariableKind::PC:
+            pc = value;
+            break;
+        default:
+            target.ram()[command.variable.address] = value;
+            break;
+    }
+
+    // a program halted in a loop may leave it once its state changes
+    target.restore(a, d, pc, target.cycles(), false);
+}
+
+void n2t::TestScript::Execution::advance(uint64_t cycles)
+{
+    auto&      target    = computer();
+    const auto available = m_options.maxCycles - std::min(m_options.maxCycles, target.cycles());
+    const auto allowed   = std::min(cycles, available);
+
+    // a test with a timeout runs the clock in slices, between which its deadline is checked
+    for (auto remaining = allowed; remaining != 0;)
+    {
+        const auto slice = m_deadline ? std::min(remaining, deadlineCheckCycles) : remaining;
+
+        // the state of a halted program does not change while the clock runs
+        const auto executed = target.run(slice);
+        target.skipCycles(slice - executed);
+        m_result.cycles = target.cycles();
+
+        remaining -= slice;
+        checkDeadline(slice);
+    }
+
+    if (allowed < cycles)
+    {
+        throw TestFailure{fmt::format("Cycle limit ({}) exceeded", m_options.maxCycles)};
+    }
+}
+
+void n2t::TestScript::Execution::checkDeadline(uint64_t cycles)
+{
+    if (!m_deadline)
+    {
+        return;
+    }
+
+    m_uncheckedCycles += cycles;
+    if (m_uncheckedCycles >= deadlineCheckCycles)
+    {
+        m_uncheckedCycles = 0;
+        if (std::chrono::steady_clock::now() >= *m_deadline)
+        {
+            throw TestFailure{fmt::format("Timeout ({} ms) exceeded", m_options.timeout.count())};
+        }
+    }
+}
+
+void n2t::TestScript::Execution::writeLine(const std::string& line)
+{
+    if (m_output.is_open())
+    {
+        m_output << line << '\n';
+    }
+
+    if (m_compare)
+    {
+        const auto lineNumber = m_result.comparedLines + 1;
+        if ((m_result.comparedLines >= m_compareLines.size()) ||
+            !matches(line, m_compareLines[m_result.comparedLines]))
+        {
+            throw TestFailure{fmt::format("Comparison failure at line {}", lineNumber)};
+        }
+        m_result.comparedLines = lineNumber;
+    }
+}
+
+void n2t::TestScript::Execution::writeHeader()
+{
+    std::string line;
+    for (const auto& column : *m_columns)
+    {
+        // the name is centered in the column
+        const auto size  = column.padLeft + column.width + column.padRight;
+        const auto name  = std::string_view{column.name}.substr(0, size);
+        const auto left  = (size - name.size()) / 2;
+        const auto right = size - name.size() - left;
+        line.append(fmt::format("|{:{}}{}{:{}}", "", left, name, "", right));
+    }
+    line.push_back('|');
+    writeLine(line);
+}
+
+void n2t::TestScript::Execution::writeValues()
+{
+    throwUnless(m_columns != nullptr,
+                "Command (output) of script ({}) requires command (output-list)",
+                m_script.m_filename.filename().string());
+
+    std::string line;
+    for (const auto& column : *m_columns)
+    {
+        const auto  value = read(column.variable);
+        const auto  bits  = static_cast<uint16_t>(value);
+        std::string text;
+        switch (column.format)
+        {
+            case 'B':
+                text = fmt::format("{:0{}b}", bits, column.width);
+                text = text.substr(text.size() - column.width);
+                break;
+            case 'X':
+                text = fmt::format("{:0{}X}", bits, column.width);
+                text = text.substr(text.size() - column.width);
+                break;
+            case 'S':
+                text = fmt::format("{:<{}}", value, column.width);
+                break;
+            default:
+                text = fmt::format("{:>{}}", value, column.width);
+                break;
+        }
+        line.append(fmt::format("|{:{}}{}{:{}}", "", column.padLeft, text, "", column.padRight));
+    }
+    line.push_back('|');
+    writeLine(line);
+}
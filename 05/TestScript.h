@@ -0,0 +1,157 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef N2T_TEST_SCRIPT_H
+#define N2T_TEST_SCRIPT_H
+
+#include "HackComputer.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace n2t
+{
+struct TestOptions
+{
+    ExecutionEngine engine    = ExecutionEngine::Superinstructions;
+    uint64_t        maxCycles = std::numeric_limits<uint64_t>::max();  // the test fails when its program exceeds it
+
+    // the test fails when it runs longer, unless the timeout is zero
+    std::chrono::milliseconds timeout{0};
+};
+
+struct TestResult
+{
+    bool                     passed = false;
+    std::string              message;  // the reason of a failure, or the end of script message
+    uint64_t                 cycles        = 0;
+    std::size_t              comparedLines = 0;
+    std::vector<std::string> echoes;  // the messages of the 'echo' commands
+};
+
+// Test script of the CPU emulator of the nand2tetris tools ('.tst'), which loads a program, sets the registers and the
+// data memory, runs the clock, and writes selected values after each step as lines of a table. Each line is compared
+// with the corresponding line of a compare file ('.cmp'), where a '*' matches any character, and the test fails at
+// the first mismatch.
+//
+// The supported commands are 'load', 'output-file', 'compare-to', 'output-list', 'set', 'repeat', 'while',
+// 'ticktock', 'tick', 'tock', 'output', 'echo' and 'clear-echo'. The variables are 'A', 'D', 'PC', 'RAM[address]'
+// and 'time', the number of cycles. A 'repeat' loop of 'ticktock' commands runs the clock in a single run of the
+// emulator, so the tests run at the speed of the execution engine. Files are relative to the directory of the
+// script, and '.asm' programs are assembled when they are loaded.
+class TestScript
+{
+public:
+    explicit TestScript(std::filesystem::path filename);
+
+    [[nodiscard]] const std::filesystem::path& filename() const
+    {
+        return m_filename;
+    }
+
+    // Runs the script on a new computer. The result is a failure if a comparison fails or if the program exceeds the
+    // cycle limit, while the other errors, such as a missing file, are thrown.
+    [[nodiscard]] TestResult run(const TestOptions& options = {}) const;
+
+private:
+    enum class CommandKind
+    {
+        Load,
+        OutputFile,
+        CompareTo,
+        OutputList,
+        Set,
+        Repeat,
+        While,
+        TickTock,
+        Tick,
+        Tock,
+        Output,
+        Echo,
+        ClearEcho
+    };
+
+    enum class VariableKind
+    {
+        A,
+        D,
+        PC,
+        Ram,
+        Time
+    };
+
+    struct Variable
+    {
+        VariableKind kind    = VariableKind::A;
+        uint16_t     address = 0;
+    };
+
+    // Column of the output table: the value of a variable written as 'padLeft' spaces, the value formatted into
+    // 'width' characters, and 'padRight' spaces.
+    struct Column
+    {
+        std::string name;
+        Variable    variable;
+        char        format   = 'D';  // 'B' binary, 'D' decimal, 'X' hexadecimal or 'S' string
+        std::size_t padLeft  = 1;
+        std::size_t width    = 6;
+        std::size_t padRight = 1;
+    };
+
+    enum class Comparison
+    {
+        Equal,
+        NotEqual,
+        Less,
+        Greater,
+        LessOrEqual,
+        GreaterOrEqual
+    };
+
+    // Command of the script. The body of a 'repeat' or 'while' loop follows the loop command, up to 'bodyEnd'.
+    struct Command
+    {
+        CommandKind         kind = CommandKind::Output;
+        std::string         text;  // file name or message
+        Variable            variable;
+        int32_t             value      = 0;  // value of 'set' or 'while', or number of iterations of 'repeat'
+        Comparison          comparison = Comparison::Equal;
+        std::vector<Column> columns;
+        std::size_t         bodyEnd = 0;
+        uint64_t            ticks   = 0;  // number of 'ticktock' commands of a 'repeat' body that contains nothing else
+    };
+
+    class Execution;
+
+    std::filesystem::path m_filename;
+    std::vector<Command>  m_commands;
+};
+}  // namespace n2t
+
+#endif
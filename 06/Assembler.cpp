@@ -23,20 +23,63 @@
  */
 
 #include "AssemblyEngine.h"
+#include "AssemblyTask.h"
 
 #include <cxxopts.hpp>
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <iostream>
 #include <stdexcept>
+#include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
+namespace
+{
+void findInputFiles(const std::filesystem::path& inputPath, n2t::PathList& inputFilenames)
+{
+    if (!std::filesystem::exists(inputPath))
+    {
+        throw std::invalid_argument{fmt::format("Input path ({}) does not exist", inputPath.string())};
+    }
+
+    if (std::filesystem::is_directory(inputPath))
+    {
+        const auto numFilenames = inputFilenames.size();
+
+        for (const auto& entry : std::filesystem::directory_iterator(inputPath))
+        {
+            const auto& path = entry.path();
+            if (std::filesystem::is_regular_file(path) && (path.extension() == ".asm"))
+            {
+                inputFilenames.push_back(path);
+            }
+        }
+
+        if (inputFilenames.size() == numFilenames)
+        {
+            throw std::invalid_argument{
+                fmt::format("Input directory ({}) does not contain assembly files", inputPath.string())};
+        }
+    }
+    else if (std::filesystem::is_regular_file(inputPath))
+    {
+        inputFilenames.push_back(inputPath);
+    }
+    else
+    {
+        throw std::invalid_argument{fmt::format("Input path ({}) is not a file nor a directory", inputPath.string())};
+    }
+}
+}  // namespace
+
 int main(int argc, char* argv[])
 {
-    int result = EXIT_FAILURE;
+    int result = EXIT_SUCCESS;
 
     const std::filesystem::path programPath{*argv};
     cxxopts::Options            options{programPath.filename(), "Hack Assembler"};
@@ -47,20 +90,31 @@ int main(int argc, char* argv[])
          * Parse command line options
          */
 
+        const int             maxThreads = std::max<int>(std::thread::hardware_concurrency(), 1);
+        auto                  numJobs    = maxThreads;
         std::filesystem::path outputFilename;
+        std::string           outputFormat;
+        bool                  optimize  = false;
+        bool                  symbolMap = false;
+        bool                  listing   = false;
 
         options.show_positional_help();
 
         // clang-format off
         options.add_options()
             ("help", "Display this help message")
+            ("f,format", "Output file format (text, bin)", cxxopts::value<std::string>(outputFormat)->default_value("text"))
+            ("j,jobs", "Run 'arg' jobs in parallel", cxxopts::value<int>(numJobs)->default_value(std::to_string(maxThreads)))
+            ("l,listing", "Write a listing file of each instruction with its source line", cxxopts::value<bool>(listing))
+            ("O,optimize", "Remove redundant instructions", cxxopts::value<bool>(optimize))
+            ("m,map", "Write a symbol map file of the labels and variables", cxxopts::value<bool>(symbolMap))
             ("o,output-file", "Output binary file", cxxopts::value<std::filesystem::path>(outputFilename));
 
         options.add_options("Positional")
-            ("input-file", "Input assembly file", cxxopts::value<std::vector<std::string>>());
+            ("input-path", "Input assembly files/directories", cxxopts::value<std::vector<std::string>>());
         // clang-format on
 
-        options.parse_positional("input-file");
+        options.parse_positional("input-path");
 
         const auto optionsMap = options.parse(argc, argv);
 
@@ -71,51 +125,90 @@ int main(int argc, char* argv[])
         }
 
         /*
-         * Get and validate input and output filenames
+         * Get and validate output format, input and output filenames
          */
 
-        const auto inputFileCount = optionsMap.count("input-file");
-        if (inputFileCount == 0)
+        n2t::AssemblyOptions assemblyOptions;
+        assemblyOptions.optimize  = optimize;
+        assemblyOptions.symbolMap = symbolMap;
+        assemblyOptions.listing   = listing;
+        if (outputFormat == "bin")
         {
-            throw cxxopts::option_required_exception{"input-file"};
+            assemblyOptions.outputFormat = n2t::RomFormat::Binary;
         }
-        if (inputFileCount != 1)
+        else if (outputFormat != "text")
         {
-            throw cxxopts::OptionParseException{"Option 'input-file' is specified more than once"};
+            throw cxxopts::OptionParseException{
+                fmt::format("Option 'format' has an invalid argument '{}'", outputFormat)};
         }
 
-        std::filesystem::path inputFilename{optionsMap["input-file"].as<std::vector<std::string>>().front()};
-        if (!std::filesystem::exists(inputFilename))
+        if (numJobs <= 0)
         {
-            throw std::invalid_argument{fmt::format("Input file ({}) does not exist", inputFilename.string())};
+            throw cxxopts::OptionParseException{fmt::format("Option 'jobs' has an invalid argument '{}'", numJobs)};
         }
-        if (!std::filesystem::is_regular_file(inputFilename))
+
+        if (optionsMap.count("input-path") == 0)
         {
-            throw std::invalid_argument{fmt::format("Input file ({}) is not a file", inputFilename.string())};
+            throw cxxopts::option_required_exception{"input-path"};
         }
 
-        if (outputFilename.empty())
+        n2t::PathList inputFilenames;
+        for (const auto& inputPath : optionsMap["input-path"].as<std::vector<std::string>>())
         {
-            outputFilename = inputFilename;
-            outputFilename.replace_extension(".hack");
+            findInputFiles(inputPath, inputFilenames);
+        }
+
+        const auto numFiles = inputFilenames.size();
+        const auto numTasks = std::min(static_cast<n2t::PathList::size_type>(numJobs), numFiles);
+        const auto taskSize = numFiles / numTasks;
+
+        // jobs that are not needed to assemble separate files in parallel are used to assemble each file in parallel
+        assemblyOptions.numThreads = static_cast<unsigned int>(numJobs / numTasks);
+
+        if (!outputFilename.empty())
+        {
+            if (numFiles != 1)
+            {
+                throw cxxopts::OptionParseException{"Option 'output-file' requires a single input file"};
+            }
+
+            /*
+             * Assemble input file
+             */
+
+            n2t::AssemblyEngine engine{inputFilenames.front(), std::move(outputFilename), assemblyOptions};
+            engine.assemble();
+
+            return EXIT_SUCCESS;
         }
 
         /*
-         * Assemble input file
+         * Execute assembly tasks
          */
 
-        n2t::AssemblyEngine engine{std::move(inputFilename), std::move(outputFilename)};
-        engine.assemble();
-
-        result = EXIT_SUCCESS;
+        std::vector<n2t::AssemblyTask> tasks;
+        tasks.reserve(numTasks - 1);
+        auto first = inputFilenames.cbegin();
+        for (auto task = decltype(numTasks){0}; task < (numTasks - 1); ++task)
+        {
+            auto last = first + taskSize;
+            tasks.emplace_back(first, last, assemblyOptions, &result);
+            first = last;
+        }
+        if (!n2t::AssemblyTask::assemble(first, inputFilenames.cend(), assemblyOptions))
+        {
+            result = EXIT_FAILURE;
+        }
     }
     catch (const cxxopts::OptionException& ex)
     {
+        result = EXIT_FAILURE;
         std::cerr << "ERROR: " << ex.what() << "\n\n";
         std::cout << options.help() << '\n';
     }
     catch (const std::exception& ex)
     {
+        result = EXIT_FAILURE;
         std::cerr << "ERROR: " << ex.what() << '\n';
     }
 
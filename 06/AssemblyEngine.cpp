@@ -27,33 +27,171 @@
 #include "Code.h"
 #include "Parser.h"
 
+#include <MappedFile.h>
 #include <Util.h>
 
 #include <boost/algorithm/string/classification.hpp>
-#include <boost/lexical_cast.hpp>
 
 #include <algorithm>
-#include <bitset>
-#include <cstdint>
+#include <array>
+#include <charconv>
 #include <fstream>
+#include <future>
 #include <iterator>
 #include <limits>
 #include <locale>
+#include <memory>
+#include <stdexcept>
+#include <string>
 #include <utility>
 
-n2t::AssemblyEngine::AssemblyEngine(std::filesystem::path inputFilename, std::filesystem::path outputFilename) :
+struct n2t::AssemblyEngine::Chunk
+{
+    struct Label
+    {
+        std::string_view symbol;
+        std::size_t      address    = 0;  // relative to the first instruction of the chunk
+        unsigned int     lineNumber = 0;
+    };
+
+    struct SymbolReference
+    {
+        std::string_view symbol;
+        std::size_t      instruction = 0;
+        unsigned int     lineNumber  = 0;
+    };
+
+    explicit Chunk(std::string_view t) : text{t}
+    {
+    }
+
+    std::string_view             text;
+    std::unique_ptr<Parser>      parser;
+    unsigned int                 numLines         = 0;
+    unsigned int                 firstLineNumber  = 0;  // number of lines preceding the chunk
+    std::size_t                  firstInstruction = 0;  // ROM address of the first instruction of the chunk
+    std::vector<uint16_t>        instructions;
+    std::vector<unsigned int>    lineNumbers;  // line number of each instruction, relative to the chunk
+    std::vector<Label>           labels;
+    std::vector<SymbolReference> symbolReferences;
+    std::vector<std::size_t>     variableReferences;  // symbol references that are not labels nor predefined
+    std::string                  error;
+    unsigned int                 errorLineNumber = 0;
+};
+
+namespace
+{
+// Input files are split into chunks of at least this size, as smaller chunks are not worth a separate thread.
+constexpr std::size_t minChunkSize = 128 * 1024;
+
+constexpr int16_t maxRomAddress = std::numeric_limits<int16_t>::max() - 1;
+
+constexpr uint16_t cInstructionBit = 0x8000;
+constexpr uint16_t destAMask       = 0b100000;
+constexpr uint16_t destMask        = 0b111000;
+constexpr uint16_t jumpMask        = 0b000111;
+
+// clang-format off
+constexpr std::array<uint16_t, 7> pushPopInstructions =
+{
+    uint16_t{0b0000000000000000},  // @SP
+    uint16_t{0b1111110111101000},  // AM=M+1
+    uint16_t{0b1110110010100000},  // A=A-1
+    uint16_t{0b1110001100001000},  // M=D
+    uint16_t{0b0000000000000000},  // @SP
+    uint16_t{0b1111110010101000},  // AM=M-1
+    uint16_t{0b1111110000010000}   // D=M
+};
+
+constexpr uint16_t loadStackPointerInstruction = 0b1111110000100000;  // A=M
+// clang-format on
+
+[[nodiscard]] constexpr bool isCInstruction(uint16_t instruction) noexcept
+{
+    return (instruction & cInstructionBit) != 0;
+}
+
+// Splits the text into at most 'maxChunks' chunks of about the same size, ending at line boundaries.
+[[nodiscard]] std::vector<std::string_view> splitLines(std::string_view text, std::size_t maxChunks)
+{
+    const auto numChunks = std::clamp<std::size_t>(text.size() / minChunkSize, 1, std::max<std::size_t>(maxChunks, 1));
+    const auto chunkSize = text.size() / numChunks;
+
+    std::vector<std::string_view> chunks;
+    chunks.reserve(numChunks);
+    while (chunks.size() < (numChunks - 1))
+    {
+        const auto lineEnd = text.find('\n', chunkSize);
+        if (lineEnd == std::string_view::npos)
+        {
+            break;
+        }
+        chunks.push_back(text.substr(/* __pos = */ 0, lineEnd + 1));
+        text.remove_prefix(lineEnd + 1);
+    }
+    chunks.push_back(text);
+
+    return chunks;
+}
+
+// Calls the function on every element, with all but the first element being processed on separate threads.
+template<typename Container, typename Function>
+void parallelForEach(Container& container, const Function& function)
+{
+    std::vector<std::future<void>> futures;
+    if (container.size() > 1)
+    {
+        futures.reserve(container.size() - 1);
+        for (auto iter = std::next(container.begin()); iter != container.end(); ++iter)
+        {
+            futures.push_back(std::async(std::launch::async, function, std::ref(*iter)));
+        }
+    }
+    if (!container.empty())
+    {
+        function(container.front());
+    }
+    for (auto& future : futures)
+    {
+        future.get();
+    }
+}
+}  // namespace
+
+n2t::AssemblyEngine::AssemblyEngine(std::filesystem::path inputFilename,
+                                    std::filesystem::path outputFilename,
+                                    AssemblyOptions       options) :
     m_inputFilename{std::move(inputFilename)},
-    m_outputFilename{std::move(outputFilename)}
+    m_outputFilename{std::move(outputFilename)},
+    m_options{options}
 {
+    if (m_options.symbolMap)
+    {
+        m_symbolMapFilename = m_outputFilename;
+        m_symbolMapFilename.replace_extension(".map");
+    }
+    if (m_options.listing)
+    {
+        m_listingFilename = m_outputFilename;
+        m_listingFilename.replace_extension(".lst");
+    }
 }
 
 n2t::AssemblyEngine::~AssemblyEngine() noexcept
 {
     try
     {
-        if (!m_assembled)
+        if (!m_assembled && !m_outputFilename.empty())
         {
             std::filesystem::remove(m_outputFilename);
+            if (!m_symbolMapFilename.empty())
+            {
+                std::filesystem::remove(m_symbolMapFilename);
+            }
+            if (!m_listingFilename.empty())
+            {
+                std::filesystem::remove(m_listingFilename);
+            }
         }
     }
     catch (...)
@@ -64,137 +202,517 @@ n2t::AssemblyEngine::~AssemblyEngine() noexcept
 void n2t::AssemblyEngine::assemble()
 {
     throwUnless(!m_assembled, "Input file ({}) has already been assembled", m_inputFilename.filename().string());
-    buildSymbolTable();
-    generateCode();
+
+    const MappedFile inputFile{m_inputFilename};
+    const auto       chunks = translate(inputFile.contents());
+
+    saveRomImage(m_outputFilename, m_instructions, m_options.outputFormat);
+
+    if (m_options.symbolMap)
+    {
+        saveSymbolMap(m_symbolMapFilename, m_symbolMap);
+    }
+    if (m_options.listing)
+    {
+        generateListing(chunks);
+    }
+
     m_assembled = true;
 }
 
-void n2t::AssemblyEngine::buildSymbolTable()
+n2t::RomImage n2t::AssemblyEngine::assembleText(std::string_view text,
+                                                std::string_view sourceName,
+                                                AssemblyOptions  options)
 {
-    Parser symbolParser{m_inputFilename.string()};
+    // no file is written by this engine
+    options.symbolMap = false;
+    options.listing   = false;
 
-    try
+    AssemblyEngine engine{sourceName, {}, options};
+    engine.translate(text);
+    engine.m_assembled = true;
+
+    return std::move(engine.m_instructions);
+}
+
+std::vector<n2t::AssemblyEngine::Chunk> n2t::AssemblyEngine::translate(std::string_view text)
+{
+    std::vector<Chunk> chunks;
+    for (const auto chunkText : splitLines(text, m_options.numThreads))
     {
-        const int16_t maxRomAddress = std::numeric_limits<int16_t>::max() - 1;
+        chunks.emplace_back(chunkText);
+    }
 
-        // ROM address to advance when a C-instruction or an A-instruction is encountered,
-        // but does not change when a label pseudocommand or a comment is encountered
-        int16_t nextRomAddress = 0;
+    parallelForEach(chunks, parse);
+    if (m_options.optimize)
+    {
+        mergeChunks(chunks);
+        while (optimize(chunks.front()))
+        {
+        }
+    }
+    addLabels(chunks);
+    parallelForEach(chunks, [this](Chunk& chunk) { resolveLabels(chunk); });
+    resolveVariables(chunks);
+    generateCode(chunks);
 
-        while (symbolParser.advance())
+    return chunks;
+}
+
+void n2t::AssemblyEngine::parse(Chunk& chunk)
+{
+    chunk.parser = std::make_unique<Parser>(chunk.text);
+    auto& parser = *chunk.parser;
+
+    try
+    {
+        while (parser.advance())
         {
-            const auto commandType = symbolParser.commandType();
-            if ((commandType == CommandType::A) || (commandType == CommandType::C))
+            const auto commandType = parser.commandType();
+            if (commandType == CommandType::A)
             {
-                throwUnless(
-                    nextRomAddress < maxRomAddress, "Instruction count exceeds the limit ({})", maxRomAddress + 1);
+                const auto symbol = parser.symbol();
+                const auto digits = std::all_of(std::next(symbol.begin()), symbol.end(), boost::algorithm::is_digit());
+                int16_t    targetAddress = 0;
 
-                ++nextRomAddress;
+                if (std::isdigit(symbol.front(), std::locale{}))
+                {
+                    if (digits)
+                    {
+                        const auto result =
+                            std::from_chars(symbol.data(), symbol.data() + symbol.size(), targetAddress);
+                        throwUnless(
+                            result.ec == std::errc{}, "Address ({}) is too large in addressing instruction", symbol);
+                    }
+                    else
+                    {
+                        throwAlways("Symbol ({}) begins with a digit in addressing instruction", symbol);
+                    }
+                }
+                else
+                {
+                    throwUnless((symbol.front() != '-') || (symbol.length() <= 1) || !digits,
+                                "Address ({}) is negative in addressing instruction",
+                                symbol);
+
+                    // this is a symbolic A-instruction, i.e. @Xxx where Xxx is a symbol rather than an integer,
+                    // which is either a label, a predefined symbol or a variable
+                    chunk.symbolReferences.push_back({symbol, chunk.instructions.size(), parser.lineNumber()});
+                }
+
+                chunk.instructions.push_back(static_cast<uint16_t>(targetAddress));
+                chunk.lineNumbers.push_back(parser.lineNumber());
+            }
+            else if (commandType == CommandType::C)
+            {
+                auto instruction = Code::instruction(parser.command());
+                if (!instruction)
+                {
+                    const auto compCode = Code::comp(parser.comp());  // 7 bits
+                    const auto destCode = Code::dest(parser.dest());  // 3 bits
+                    const auto jumpCode = Code::jump(parser.jump());  // 3 bits
+
+                    instruction =
+                        static_cast<uint16_t>((uint16_t{0b111} << 13) | (compCode << 6) | (destCode << 3) | jumpCode);
+                }
+
+                chunk.instructions.push_back(*instruction);
+                chunk.lineNumbers.push_back(parser.lineNumber());
             }
             else if (commandType == CommandType::L)
             {
-                const auto& symbol = symbolParser.symbol();
+                const auto symbol = parser.symbol();
                 throwUnless(!std::isdigit(symbol.front(), std::locale{}),
                             "Symbol ({}) begins with a digit in label command",
                             symbol);
 
                 // associate the symbol with the ROM address that will store the next command in the program
-                m_symbolTable.addEntry(symbol, nextRomAddress);
+                chunk.labels.push_back({symbol, chunk.instructions.size(), parser.lineNumber()});
             }
         }
     }
     catch (const std::exception& ex)
     {
-        throwAlways({m_inputFilename.filename().string(), symbolParser.lineNumber()}, ex.what());
+        chunk.error           = ex.what();
+        chunk.errorLineNumber = parser.lineNumber();
     }
+
+    chunk.numLines = parser.lineNumber();
 }
 
-void n2t::AssemblyEngine::generateCode()
+void n2t::AssemblyEngine::mergeChunks(std::vector<Chunk>& chunks)
 {
-    Parser codeParser{m_inputFilename.string()};
+    auto& merged = chunks.front();
+    for (auto chunk = std::next(chunks.begin()); chunk != chunks.end(); ++chunk)
+    {
+        if (merged.error.empty())
+        {
+            const auto firstInstruction = merged.instructions.size();
+            const auto firstLineNumber  = merged.numLines;
+
+            for (auto label : chunk->labels)
+            {
+                label.address += firstInstruction;
+                label.lineNumber += firstLineNumber;
+                merged.labels.push_back(label);
+            }
+            for (auto reference : chunk->symbolReferences)
+            {
+                reference.instruction += firstInstruction;
+                reference.lineNumber += firstLineNumber;
+                merged.symbolReferences.push_back(reference);
+            }
+            for (const auto lineNumber : chunk->lineNumbers)
+            {
+                merged.lineNumbers.push_back(firstLineNumber + lineNumber);
+            }
+            merged.instructions.insert(
+                merged.instructions.end(), chunk->instructions.begin(), chunk->instructions.end());
 
-    std::ofstream outputFile{m_outputFilename.string().data()};
-    throwUnless<std::runtime_error>(outputFile.good(), "Could not open output file ({})", m_outputFilename.string());
+            if (!chunk->error.empty())
+            {
+                merged.error           = std::move(chunk->error);
+                merged.errorLineNumber = firstLineNumber + chunk->errorLineNumber;
+            }
 
-    try
+            // the chunks are consecutive views of the input file
+            merged.text = {merged.text.data(), merged.text.size() + chunk->text.size()};
+            merged.numLines += chunk->numLines;
+        }
+
+        // the parser of the chunk is kept, as it may own the text of the merged symbols
+        chunk->text     = {};
+        chunk->numLines = 0;
+        chunk->instructions.clear();
+        chunk->lineNumbers.clear();
+        chunk->labels.clear();
+        chunk->symbolReferences.clear();
+        chunk->error.clear();
+    }
+}
+
+bool n2t::AssemblyEngine::optimize(Chunk& chunk)
+{
+    if (!chunk.error.empty())
+    {
+        // the instruction count determines which error is reported first, so it must not change
+        return false;
+    }
+
+    const auto numInstructions = chunk.instructions.size();
+    const auto& instructions   = chunk.instructions;
+
+    std::vector<std::string_view> symbols(numInstructions);
+    for (const auto& reference : chunk.symbolReferences)
+    {
+        symbols[reference.instruction] = reference.symbol;
+    }
+
+    std::vector<bool> labelled(numInstructions + 1);
+    for (const auto& label : chunk.labels)
     {
-        const int16_t baseRamAddress = 0x0010;
-        const int16_t maxRamAddress  = std::numeric_limits<int16_t>::max() - 1;
+        labelled[label.address] = true;
+    }
 
-        int16_t nextRamAddress = baseRamAddress;
+    const auto isAddress = [&](std::size_t index) {
+        return (index < numInstructions) && !isCInstruction(instructions[index]);
+    };
 
-        while (codeParser.advance())
+    const auto isLabel = [&](std::string_view symbol, std::size_t address) {
+        // the labels are sorted by address
+        auto label = std::lower_bound(chunk.labels.begin(),
+                                      chunk.labels.end(),
+                                      address,
+                                      [](const auto& l, std::size_t a) { return l.address < a; });
+        for (; (label != chunk.labels.end()) && (label->address == address); ++label)
         {
-            const auto commandType = codeParser.commandType();
-            if (commandType == CommandType::A)
+            if (label->symbol == symbol)
             {
-                const auto& symbol = codeParser.symbol();
-                const auto  digits = std::all_of(std::next(symbol.begin()), symbol.end(), boost::algorithm::is_digit());
-                int16_t     targetAddress = 0;
+                return true;
+            }
+        }
+        return false;
+    };
 
-                if (std::isdigit(symbol.front(), std::locale{}))
-                {
-                    if (digits)
-                    {
-                        try
-                        {
-                            targetAddress = boost::lexical_cast<int16_t>(symbol);
-                        }
-                        catch (const boost::bad_lexical_cast&)
-                        {
-                            throwAlways("Address ({}) is too large in addressing instruction", symbol);
-                        }
-                    }
-                    else
-                    {
-                        throwAlways("Symbol ({}) begins with a digit in addressing instruction", symbol);
-                    }
-                }
-                else
+    const auto isPushPop = [&](std::size_t index) {
+        if ((index + pushPopInstructions.size()) > numInstructions)
+        {
+            return false;
+        }
+        for (std::size_t offset = 0; offset < pushPopInstructions.size(); ++offset)
+        {
+            const auto i = index + offset;
+            if ((instructions[i] != pushPopInstructions[offset]) || ((offset != 0) && labelled[i]) ||
+                (isAddress(i) && (symbols[i] != "SP")))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    const auto isJumpToNext = [&](std::size_t index) {
+        return !symbols[index].empty() && (index + 1 < numInstructions) && !labelled[index + 1] &&
+               isCInstruction(instructions[index + 1]) && ((instructions[index + 1] & destMask) == 0) &&
+               ((instructions[index + 1] & jumpMask) != 0) && isLabel(symbols[index], index + 2) &&
+               isAddress(index + 2);
+    };
+
+    std::vector<bool> removed(numInstructions);
+    std::size_t       numRemoved = 0;
+    const auto        remove     = [&](std::size_t first, std::size_t count) {
+        std::fill_n(removed.begin() + static_cast<std::ptrdiff_t>(first), count, true);
+        numRemoved += count;
+    };
+
+    // the A-instruction that loaded the current value of the A register, if known
+    constexpr auto unknownAddress = std::numeric_limits<std::size_t>::max();
+    std::size_t    addressLoad    = unknownAddress;
+
+    for (std::size_t index = 0; index < numInstructions; ++index)
+    {
+        if (labelled[index])
+        {
+            addressLoad = unknownAddress;
+        }
+
+        if (isPushPop(index))
+        {
+            if (isAddress(index + pushPopInstructions.size()) && !labelled[index + pushPopInstructions.size()])
+            {
+                remove(index, pushPopInstructions.size());
+            }
+            else
+            {
+                chunk.instructions[index + 1] = loadStackPointerInstruction;
+                remove(index + 2, pushPopInstructions.size() - 2);
+            }
+            addressLoad = unknownAddress;
+            index += pushPopInstructions.size() - 1;
+        }
+        else if (isAddress(index))
+        {
+            if (isAddress(index + 1) && !labelled[index + 1])
+            {
+                remove(index, 1);
+            }
+            else if (isJumpToNext(index))
+            {
+                remove(index, 2);
+                addressLoad = unknownAddress;
+                ++index;
+            }
+            else if ((addressLoad != unknownAddress) && (symbols[addressLoad] == symbols[index]) &&
+                     (instructions[addressLoad] == instructions[index]))
+            {
+                remove(index, 1);
+            }
+            else
+            {
+                addressLoad = index;
+            }
+        }
+        else if ((instructions[index] & destAMask) != 0)
+        {
+            addressLoad = unknownAddress;
+        }
+    }
+
+    if (numRemoved == 0)
+    {
+        return false;
+    }
+
+    // compact the instructions, and map the old instruction indices to the new ones
+    std::vector<std::size_t> newIndices(numInstructions + 1);
+    std::size_t              newIndex = 0;
+    for (std::size_t index = 0; index < numInstructions; ++index)
+    {
+        newIndices[index] = newIndex;
+        if (!removed[index])
+        {
+            chunk.instructions[newIndex] = chunk.instructions[index];
+            chunk.lineNumbers[newIndex]  = chunk.lineNumbers[index];
+            ++newIndex;
+        }
+    }
+    newIndices[numInstructions] = newIndex;
+    chunk.instructions.resize(newIndex);
+    chunk.lineNumbers.resize(newIndex);
+
+    for (auto& label : chunk.labels)
+    {
+        label.address = newIndices[label.address];
+    }
+
+    std::erase_if(chunk.symbolReferences, [&](const auto& reference) { return removed[reference.instruction]; });
+    for (auto& reference : chunk.symbolReferences)
+    {
+        reference.instruction = newIndices[reference.instruction];
+    }
+
+    return true;
+}
+
+void n2t::AssemblyEngine::addLabels(std::vector<Chunk>& chunks)
+{
+    std::size_t  firstInstruction = 0;
+    unsigned int firstLineNumber  = 0;
+
+    for (auto& chunk : chunks)
+    {
+        chunk.firstInstruction = firstInstruction;
+        chunk.firstLineNumber  = firstLineNumber;
+
+        // report errors in the order in which they would be encountered when parsing the whole file sequentially
+        const auto overflow = (firstInstruction + chunk.instructions.size()) > maxRomAddress;
+        const auto overflowLineNumber =
+            overflow ? chunk.lineNumbers[maxRomAddress - firstInstruction] : std::numeric_limits<unsigned int>::max();
+
+        for (const auto& label : chunk.labels)
+        {
+            if (label.lineNumber > overflowLineNumber)
+            {
+                break;
+            }
+
+            const auto address = static_cast<uint16_t>(firstInstruction + label.address);
+            try
+            {
+                m_symbolTable.addEntry(label.symbol, static_cast<int16_t>(address));
+            }
+            catch (const std::exception& ex)
+            {
+                throwError(chunk, label.lineNumber, ex.what());
+            }
+
+            if (m_options.symbolMap)
+            {
+                m_symbolMap.push_back({std::string{label.symbol}, address, SymbolKind::Label});
+            }
+        }
+
+        if (overflow)
+        {
+            throwError(
+                chunk, overflowLineNumber, fmt::format("Instruction count exceeds the limit ({})", maxRomAddress + 1));
+        }
+        if (!chunk.error.empty())
+        {
+            throwError(chunk, chunk.errorLineNumber, chunk.error);
+        }
+
+        firstInstruction += chunk.instructions.size();
+        firstLineNumber += chunk.numLines;
+    }
+}
+
+void n2t::AssemblyEngine::resolveLabels(Chunk& chunk) const
+{
+    for (std::size_t index = 0; index < chunk.symbolReferences.size(); ++index)
+    {
+        const auto& reference = chunk.symbolReferences[index];
+        if (const auto address = m_symbolTable.findAddress(reference.symbol))
+        {
+            // replace the symbol with its associated address
+            chunk.instructions[reference.instruction] = static_cast<uint16_t>(*address);
+        }
+        else
+        {
+            chunk.variableReferences.push_back(index);
+        }
+    }
+}
+
+void n2t::AssemblyEngine::resolveVariables(std::vector<Chunk>& chunks)
+{
+    const int16_t baseRamAddress = 0x0010;
+    const int16_t maxRamAddress  = std::numeric_limits<int16_t>::max() - 1;
+
+    int16_t nextRamAddress = baseRamAddress;
+
+    for (auto& chunk : chunks)
+    {
+        for (const auto index : chunk.variableReferences)
+        {
+            const auto& reference = chunk.symbolReferences[index];
+            try
+            {
+                // if the symbol represents a new variable,
+                // associate the variable with the next available RAM address
+                const auto [address, added] = m_symbolTable.getOrAddEntry(reference.symbol, nextRamAddress);
+                if (added)
                 {
-                    throwUnless((symbol.front() != '-') || (symbol.length() <= 1) || !digits,
-                                "Address ({}) is negative in addressing instruction",
-                                symbol);
+                    throwUnless(
+                        nextRamAddress < maxRamAddress, "Variable count exceeds the limit ({})", maxRamAddress + 1);
 
-                    // this is a symbolic A-instruction, i.e. @Xxx where Xxx is a symbol rather than an integer
-                    if (m_symbolTable.contains(symbol))
+                    if (m_options.symbolMap)
                     {
-                        // replace the symbol with its associated address
-                        targetAddress = m_symbolTable.getAddress(symbol);
+                        m_symbolMap.push_back(
+                            {std::string{reference.symbol}, static_cast<uint16_t>(address), SymbolKind::Variable});
                     }
-                    else
-                    {
-                        // the symbol represents a new variable
-                        // associate the variable with the next available RAM address
-                        m_symbolTable.addEntry(symbol, nextRamAddress);
-                        targetAddress = nextRamAddress;
-
-                        throwUnless(
-                            nextRamAddress < maxRamAddress, "Variable count exceeds the limit ({})", maxRamAddress + 1);
 
-                        ++nextRamAddress;
-                    }
+                    ++nextRamAddress;
                 }
 
-                // NOLINTNEXTLINE(readability-magic-numbers)
-                outputFile << "0" << std::bitset<15>(targetAddress) << '\n';
+                // replace the symbol with its associated address
+                chunk.instructions[reference.instruction] = static_cast<uint16_t>(address);
             }
-            else if (commandType == CommandType::C)
+            catch (const std::exception& ex)
             {
-                const auto compCode = Code::comp(codeParser.comp());  // 7 bits
-                const auto destCode = Code::dest(codeParser.dest());  // 3 bits
-                const auto jumpCode = Code::jump(codeParser.jump());  // 3 bits
-
-                const auto instruction =
-                    static_cast<uint16_t>((uint16_t{0b111} << 13) | (compCode << 6) | (destCode << 3) | jumpCode);
-
-                // NOLINTNEXTLINE(readability-magic-numbers)
-                outputFile << std::bitset<16>(instruction) << '\n';
+                throwError(chunk, reference.lineNumber, ex.what());
             }
         }
     }
-    catch (const std::exception& ex)
+}
+
+void n2t::AssemblyEngine::generateCode(const std::vector<Chunk>& chunks)
+{
+    for (const auto& chunk : chunks)
+    {
+        m_instructions.insert(m_instructions.end(), chunk.instructions.begin(), chunk.instructions.end());
+    }
+}
+
+void n2t::AssemblyEngine::generateListing(const std::vector<Chunk>& chunks) const
+{
+    fmt::memory_buffer buffer;
+    auto               out = std::back_inserter(buffer);
+
+    for (const auto& chunk : chunks)
     {
-        throwAlways({m_inputFilename.filename().string(), codeParser.lineNumber()}, ex.what());
+        // the line numbers of the instructions are increasing, so each chunk is scanned once
+        auto         text       = chunk.text;
+        unsigned int lineNumber = 1;
+
+        for (std::size_t index = 0; index < chunk.instructions.size(); ++index)
+        {
+            for (; lineNumber < chunk.lineNumbers[index]; ++lineNumber)
+            {
+                text.remove_prefix(std::min(text.find('\n') + 1, text.size()));
+            }
+
+            auto       line  = text.substr(0, text.find('\n'));
+            const auto first = line.find_first_not_of(" \t");
+            line.remove_prefix(std::min(first, line.size()));
+            line.remove_suffix(line.size() - (line.find_last_not_of(" \t\r") + 1));
+
+            fmt::format_to(out,
+                           "{:04X} {:016b} {} {}\n",
+                           chunk.firstInstruction + index,
+                           chunk.instructions[index],
+                           chunk.firstLineNumber + chunk.lineNumbers[index],
+                           line);
+        }
     }
+
+    std::ofstream file{m_listingFilename, std::ios::binary};
+    throwUnless<std::runtime_error>(file.good(), "Could not open output file ({})", m_listingFilename.string());
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    throwUnless<std::runtime_error>(file.good(), "Could not write output file ({})", m_listingFilename.string());
+}
+
+void n2t::AssemblyEngine::throwError(const Chunk& chunk, unsigned int lineNumber, std::string_view message) const
+{
+    throwAlways({m_inputFilename.filename().string(), chunk.firstLineNumber + lineNumber}, "{}", message);
 }
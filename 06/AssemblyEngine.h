@@ -27,15 +27,45 @@
 
 #include "SymbolTable.h"
 
+#include <RomImage.h>
+#include <SymbolMap.h>
+
+#include <cstdint>
 #include <filesystem>
+#include <ranges>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace n2t
 {
+struct AssemblyOptions
+{
+    RomFormat    outputFormat = RomFormat::Text;
+    unsigned int numThreads   = 1;  // number of threads assembling each file
+
+    // Removes redundant instructions from the parsed program before addresses are assigned (see 'optimize').
+    bool optimize = false;
+
+    // Writes the labels and variables with their addresses to a symbol map file ('.map') next to the output file.
+    bool symbolMap = false;
+
+    // Writes a listing file ('.lst') next to the output file, with one line per instruction:
+    //
+    //   <address> <instruction> <line number> <source line>
+    //
+    // where the ROM address is four hexadecimal digits and the instruction is sixteen binary digits.
+    bool listing = false;
+};
+
 class AssemblyEngine
 {
 public:
-    AssemblyEngine(std::filesystem::path inputFilename, std::filesystem::path outputFilename);
+    // Large input files are split into chunks at line boundaries which are assembled on up to
+    // 'options.numThreads' threads.
+    AssemblyEngine(std::filesystem::path inputFilename,
+                   std::filesystem::path outputFilename,
+                   AssemblyOptions       options = {});
 
     AssemblyEngine(const AssemblyEngine&) = delete;
     AssemblyEngine(AssemblyEngine&&)      = delete;
@@ -47,17 +77,78 @@ public:
 
     void assemble();
 
+    // Assembles a program held in memory and returns its binary code, without reading or writing any file. The
+    // source name is used in error messages.
+    [[nodiscard]] static RomImage assembleText(std::string_view text,
+                                               std::string_view sourceName,
+                                               AssemblyOptions  options = {});
+
+    // Assembles a program given as a range of lines, such as the commands generated by a translator.
+    template<std::ranges::input_range Lines>
+    [[nodiscard]] static RomImage assembleLines(const Lines&     lines,
+                                                std::string_view sourceName,
+                                                AssemblyOptions  options = {})
+    {
+        std::string text;
+        for (const auto& line : lines)
+        {
+            text.append(line);
+            text.push_back('\n');
+        }
+        return assembleText(text, sourceName, options);
+    }
+
 private:
-    // Builds the symbol table without generating any code.
-    void buildSymbolTable();
+    struct Chunk;
+
+    // Translates the whole program into binary code, stored in 'm_instructions'.
+    std::vector<Chunk> translate(std::string_view text);
+
+    // Parses a chunk of the input file in a single pass, translating each instruction into binary code and
+    // recording its labels and its symbolic A-instructions, which are resolved once all chunks have been parsed.
+    static void parse(Chunk& chunk);
+
+    // Moves the parsed instructions of all chunks into the first chunk, so that they can be optimized as a single
+    // stream. Chunks following a chunk with a parse error are discarded, as they would not be parsed sequentially.
+    static void mergeChunks(std::vector<Chunk>& chunks);
+
+    // Applies peephole optimizations to the parsed instructions of the chunk until none applies, and returns whether
+    // any instruction was removed. Labels are barriers: an instruction preceded by a label can be reached from
+    // elsewhere, so the state of the A register is unknown there. The optimizations are:
+    // - an A-instruction immediately followed by another A-instruction is removed,
+    // - an A-instruction loading the value already held in the A register is removed,
+    // - a jump to the instruction that follows it is removed, if that instruction is an A-instruction,
+    // - a push of the D register immediately followed by a pop into the D register, as generated by the VM
+    //   translator, is replaced with '@SP, A=M', or is removed if it is followed by an A-instruction.
+    static bool optimize(Chunk& chunk);
+
+    // Associates each label with its ROM address, which is given by the number of instructions preceding it.
+    void addLabels(std::vector<Chunk>& chunks);
+
+    // Replaces each symbol that refers to a label or to a predefined symbol with its address.
+    // Symbols that cannot be resolved are recorded as variables.
+    void resolveLabels(Chunk& chunk) const;
+
+    // Replaces each variable with its address, allocating RAM addresses to variables in the order of their first
+    // use.
+    void resolveVariables(std::vector<Chunk>& chunks);
+
+    // Concatenates the binary code of the chunks.
+    void generateCode(const std::vector<Chunk>& chunks);
+
+    // Writes each instruction together with the source line it was translated from to the listing file.
+    void generateListing(const std::vector<Chunk>& chunks) const;
 
-    // Replaces each symbol with its corresponding meaning (numeric address)
-    // and generates the final binary code.
-    void generateCode();
+    [[noreturn]] void throwError(const Chunk& chunk, unsigned int lineNumber, std::string_view message) const;
 
     std::filesystem::path m_inputFilename;
     std::filesystem::path m_outputFilename;
+    std::filesystem::path m_symbolMapFilename;
+    std::filesystem::path m_listingFilename;
+    AssemblyOptions       m_options;
     SymbolTable           m_symbolTable;
+    SymbolMap             m_symbolMap;
+    std::vector<uint16_t> m_instructions;
     bool                  m_assembled = false;
 };
 }  // namespace n2t
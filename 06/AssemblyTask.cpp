@@ -0,0 +1,123 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "AssemblyTask.h"
+
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace
+{
+void reportError(std::string_view message)
+{
+    // serialize error messages from concurrent tasks so that they are not interleaved
+    static std::mutex                 errorMutex;
+    const std::lock_guard<std::mutex> lock{errorMutex};
+    std::cerr << "ERROR: " << message << '\n';
+}
+}  // namespace
+
+n2t::AssemblyTask::AssemblyTask(const PathList& inputFilenames, AssemblyOptions options, int* result) :
+    AssemblyTask{inputFilenames.cbegin(), inputFilenames.cend(), options, result}
+{
+}
+
+n2t::AssemblyTask::AssemblyTask(PathList::const_iterator firstFilename,
+                                PathList::const_iterator lastFilename,
+                                AssemblyOptions          options,
+                                int*                     result) :
+    m_future{std::async(std::launch::async, assembleFileRange, firstFilename, lastFilename, options)},
+    m_result{result}
+{
+}
+
+n2t::AssemblyTask::~AssemblyTask() noexcept
+{
+    try
+    {
+        if (m_future.valid() && !m_future.get() && m_result)
+        {
+            *m_result = EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        if (m_result)
+        {
+            *m_result = EXIT_FAILURE;
+        }
+        reportError(ex.what());
+    }
+}
+
+bool n2t::AssemblyTask::assemble(const PathList& inputFilenames, AssemblyOptions options)
+{
+    return assembleFileRange(inputFilenames.cbegin(), inputFilenames.cend(), options);
+}
+
+bool n2t::AssemblyTask::assemble(PathList::const_iterator firstFilename,
+                                 PathList::const_iterator lastFilename,
+                                 AssemblyOptions          options)
+{
+    return assembleFileRange(firstFilename, lastFilename, options);
+}
+
+bool n2t::AssemblyTask::assembleFileRange(PathList::const_iterator firstFilename,
+                                          PathList::const_iterator lastFilename,
+                                          AssemblyOptions          options)
+{
+    bool success = true;
+
+    // clang-format off
+    std::for_each(firstFilename,
+                  lastFilename,
+                  [options, &success](const auto& filename)
+                  {
+                      try
+                      {
+                          assembleFile(filename, options);
+                      }
+                      catch (const std::exception& ex)
+                      {
+                          success = false;
+                          reportError(ex.what());
+                      }
+                  });
+    // clang-format on
+
+    return success;
+}
+
+void n2t::AssemblyTask::assembleFile(const std::filesystem::path& inputFilename, AssemblyOptions options)
+{
+    auto outputFilename = inputFilename;
+    outputFilename.replace_extension(".hack");
+
+    AssemblyEngine engine{inputFilename, std::move(outputFilename), options};
+    engine.assemble();
+}
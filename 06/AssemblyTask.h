@@ -0,0 +1,77 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef N2T_ASSEMBLY_TASK_H
+#define N2T_ASSEMBLY_TASK_H
+
+#include "AssemblyEngine.h"
+
+#include <filesystem>
+#include <future>
+#include <vector>
+
+namespace n2t
+{
+using PathList = std::vector<std::filesystem::path>;
+
+// Assembles a range of input files on a separate thread. An error in one file is reported without aborting the
+// assembly of the remaining files.
+class AssemblyTask
+{
+public:
+    explicit AssemblyTask(const PathList& inputFilenames, AssemblyOptions options = {}, int* result = nullptr);
+
+    explicit AssemblyTask(PathList::const_iterator firstFilename,
+                          PathList::const_iterator lastFilename,
+                          AssemblyOptions          options = {},
+                          int*                     result  = nullptr);
+
+    AssemblyTask(const AssemblyTask&)     = delete;
+    AssemblyTask(AssemblyTask&&) noexcept = default;
+
+    AssemblyTask& operator=(const AssemblyTask&) = delete;
+    AssemblyTask& operator=(AssemblyTask&&) noexcept = default;
+
+    ~AssemblyTask() noexcept;
+
+    // Assembles the input files on the calling thread and returns whether all of them were assembled.
+    [[nodiscard]] static bool assemble(const PathList& inputFilenames, AssemblyOptions options = {});
+
+    [[nodiscard]] static bool assemble(PathList::const_iterator firstFilename,
+                                       PathList::const_iterator lastFilename,
+                                       AssemblyOptions          options = {});
+
+private:
+    [[nodiscard]] static bool assembleFileRange(PathList::const_iterator firstFilename,
+                                                PathList::const_iterator lastFilename,
+                                                AssemblyOptions          options);
+
+    static void assembleFile(const std::filesystem::path& inputFilename, AssemblyOptions options);
+
+    std::future<bool> m_future;
+    int*              m_result = nullptr;
+};
+}  // namespace n2t
+
+#endif
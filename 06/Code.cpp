@@ -28,6 +28,173 @@
 
 #include <frozen/unordered_map.h>
 
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+namespace
+{
+using Mnemonic = std::pair<frozen::string, uint16_t>;
+
+// clang-format off
+constexpr Mnemonic destMnemonics[] =
+{
+    {"M",   uint16_t{0b001}},
+    {"D",   uint16_t{0b010}},
+    {"MD",  uint16_t{0b011}},
+    {"A",   uint16_t{0b100}},
+    {"AM",  uint16_t{0b101}},
+    {"AD",  uint16_t{0b110}},
+    {"AMD", uint16_t{0b111}}
+};
+
+constexpr Mnemonic compMnemonics[] =
+{
+    {"0",   uint16_t{0b0101010}},
+    {"1",   uint16_t{0b0111111}},
+    {"-1",  uint16_t{0b0111010}},
+    {"D",   uint16_t{0b0001100}},
+    {"A",   uint16_t{0b0110000}},
+    {"M",   uint16_t{0b1110000}},
+    {"!D",  uint16_t{0b0001101}},
+    {"!A",  uint16_t{0b0110001}},
+    {"!M",  uint16_t{0b1110001}},
+    {"-D",  uint16_t{0b0001111}},
+    {"-A",  uint16_t{0b0110011}},
+    {"-M",  uint16_t{0b1110011}},
+    {"D+1", uint16_t{0b0011111}},
+    {"A+1", uint16_t{0b0110111}},
+    {"M+1", uint16_t{0b1110111}},
+    {"D-1", uint16_t{0b0001110}},
+    {"A-1", uint16_t{0b0110010}},
+    {"M-1", uint16_t{0b1110010}},
+    {"D+A", uint16_t{0b0000010}},
+    {"D+M", uint16_t{0b1000010}},
+    {"D-A", uint16_t{0b0010011}},
+    {"D-M", uint16_t{0b1010011}},
+    {"A-D", uint16_t{0b0000111}},
+    {"M-D", uint16_t{0b1000111}},
+    {"D&A", uint16_t{0b0000000}},
+    {"D&M", uint16_t{0b1000000}},
+    {"D|A", uint16_t{0b0010101}},
+    {"D|M", uint16_t{0b1010101}}
+};
+
+constexpr Mnemonic jumpMnemonics[] =
+{
+    {"JGT", uint16_t{0b001}},
+    {"JEQ", uint16_t{0b010}},
+    {"JGE", uint16_t{0b011}},
+    {"JLT", uint16_t{0b100}},
+    {"JNE", uint16_t{0b101}},
+    {"JLE", uint16_t{0b110}},
+    {"JMP", uint16_t{0b111}}
+};
+// clang-format on
+
+constexpr auto destCodes = frozen::make_unordered_map(destMnemonics);
+constexpr auto compCodes = frozen::make_unordered_map(compMnemonics);
+constexpr auto jumpCodes = frozen::make_unordered_map(jumpMnemonics);
+
+// Inverts a table of mnemonics into an array of mnemonics indexed by binary code.
+template<std::size_t Size, std::size_t N>
+[[nodiscard]] constexpr auto invertMnemonics(const Mnemonic (&mnemonics)[N])
+{
+    std::array<std::string_view, Size> names{};
+    for (const auto& mnemonic : mnemonics)
+    {
+        names[mnemonic.second] = {mnemonic.first.data(), mnemonic.first.size()};
+    }
+    return names;
+}
+
+constexpr auto destNames = invertMnemonics<8>(destMnemonics);
+constexpr auto compNames = invertMnemonics<128>(compMnemonics);
+constexpr auto jumpNames = invertMnemonics<8>(jumpMnemonics);
+
+// Entry of the table of C-instructions, holding the text 'dest=comp;jump' and its binary code.
+struct CInstruction
+{
+    static constexpr std::size_t maxLength = 11;  // AMD=D|M;JMP
+
+    std::array<char, maxLength> text{};
+    std::size_t                 length = 0;
+    uint16_t                    code   = 0;
+
+    [[nodiscard]] constexpr std::string_view view() const noexcept
+    {
+        return {text.data(), length};
+    }
+};
+
+// The table holds every combination of the 'dest', 'comp' and 'jump' mnemonics (8 * 28 * 8 = 1792), and uses open
+// addressing with linear probing. The load factor is below one half to keep the probe sequences short.
+constexpr std::size_t cInstructionTableSize = 4096;
+
+// FNV-1a hash function.
+[[nodiscard]] constexpr std::size_t hashInstruction(std::string_view instruction) noexcept
+{
+    uint32_t hash = 2166136261U;  // NOLINT(readability-magic-numbers)
+    for (const auto c : instruction)
+    {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619U;  // NOLINT(readability-magic-numbers)
+    }
+    return hash;
+}
+
+constexpr auto cInstructions = []
+{
+    std::array<CInstruction, cInstructionTableSize> table{};
+
+    // index zero stands for an omitted 'dest' or 'jump' field
+    for (std::size_t dest = 0; dest <= std::size(destMnemonics); ++dest)
+    {
+        for (const auto& comp : compMnemonics)
+        {
+            for (std::size_t jump = 0; jump <= std::size(jumpMnemonics); ++jump)
+            {
+                CInstruction entry;
+                const auto   append = [&entry](const frozen::string& str)
+                {
+                    for (std::size_t i = 0; i < str.size(); ++i)
+                    {
+                        entry.text[entry.length++] = str[i];
+                    }
+                };
+
+                uint16_t destCode = 0b000;
+                uint16_t jumpCode = 0b000;
+                if (dest != 0)
+                {
+                    append(destMnemonics[dest - 1].first);
+                    append("=");
+                    destCode = destMnemonics[dest - 1].second;
+                }
+                append(comp.first);
+                if (jump != 0)
+                {
+                    append(";");
+                    append(jumpMnemonics[jump - 1].first);
+                    jumpCode = jumpMnemonics[jump - 1].second;
+                }
+                entry.code =
+                    static_cast<uint16_t>((uint16_t{0b111} << 13) | (comp.second << 6) | (destCode << 3) | jumpCode);
+
+                auto slot = hashInstruction(entry.view()) % table.size();
+                while (table[slot].length != 0)
+                {
+                    slot = (slot + 1) % table.size();
+                }
+                table[slot] = entry;
+            }
+        }
+    }
+
+    return table;
+}();
+}  // namespace
+
 uint16_t n2t::Code::dest(std::string_view dest)
 {
     if (dest.empty())
@@ -35,19 +202,6 @@ uint16_t n2t::Code::dest(std::string_view dest)
         return 0b000;
     }
 
-    // clang-format off
-    static constexpr auto destCodes = frozen::make_unordered_map<frozen::string, uint16_t>(
-    {
-        {"M",   uint16_t{0b001}},
-        {"D",   uint16_t{0b010}},
-        {"MD",  uint16_t{0b011}},
-        {"A",   uint16_t{0b100}},
-        {"AM",  uint16_t{0b101}},
-        {"AD",  uint16_t{0b110}},
-        {"AMD", uint16_t{0b111}}
-    });
-    // clang-format on
-
     const auto iter = destCodes.find(toFrozenString(dest));  // NOLINT(readability-qualified-auto)
     throwUnless(iter != destCodes.end(), "Invalid 'dest' mnemonic ({})", dest);
 
@@ -56,40 +210,6 @@ uint16_t n2t::Code::dest(std::string_view dest)
 
 uint16_t n2t::Code::comp(std::string_view comp)
 {
-    // clang-format off
-    static constexpr auto compCodes = frozen::make_unordered_map<frozen::string, uint16_t>(
-    {
-        {"0",   uint16_t{0b0101010}},
-        {"1",   uint16_t{0b0111111}},
-        {"-1",  uint16_t{0b0111010}},
-        {"D",   uint16_t{0b0001100}},
-        {"A",   uint16_t{0b0110000}},
-        {"M",   uint16_t{0b1110000}},
-        {"!D",  uint16_t{0b0001101}},
-        {"!A",  uint16_t{0b0110001}},
-        {"!M",  uint16_t{0b1110001}},
-        {"-D",  uint16_t{0b0001111}},
-        {"-A",  uint16_t{0b0110011}},
-        {"-M",  uint16_t{0b1110011}},
-        {"D+1", uint16_t{0b0011111}},
-        {"A+1", uint16_t{0b0110111}},
-        {"M+1", uint16_t{0b1110111}},
-        {"D-1", uint16_t{0b0001110}},
-        {"A-1", uint16_t{0b0110010}},
-        {"M-1", uint16_t{0b1110010}},
-        {"D+A", uint16_t{0b0000010}},
-        {"D+M", uint16_t{0b1000010}},
-        {"D-A", uint16_t{0b0010011}},
-        {"D-M", uint16_t{0b1010011}},
-        {"A-D", uint16_t{0b0000111}},
-        {"M-D", uint16_t{0b1000111}},
-        {"D&A", uint16_t{0b0000000}},
-        {"D&M", uint16_t{0b1000000}},
-        {"D|A", uint16_t{0b0010101}},
-        {"D|M", uint16_t{0b1010101}}
-    });
-    // clang-format on
-
     const auto iter = compCodes.find(toFrozenString(comp));  // NOLINT(readability-qualified-auto)
     throwUnless(iter != compCodes.end(), "Invalid 'comp' mnemonic ({})", comp);
 
@@ -103,16 +223,49 @@ uint16_t n2t::Code::jump(std::string_view jump)
         return 0b000;
     }
 
-    static constexpr auto jumpCodes = frozen::make_unordered_map<frozen::string, uint16_t>({{"JGT", uint16_t{0b001}},
-                                                                                            {"JEQ", uint16_t{0b010}},
-                                                                                            {"JGE", uint16_t{0b011}},
-                                                                                            {"JLT", uint16_t{0b100}},
-                                                                                            {"JNE", uint16_t{0b101}},
-                                                                                            {"JLE", uint16_t{0b110}},
-                                                                                            {"JMP", uint16_t{0b111}}});
-
     const auto iter = jumpCodes.find(toFrozenString(jump));  // NOLINT(readability-qualified-auto)
     throwUnless(iter != jumpCodes.end(), "Invalid 'jump' mnemonic ({})", jump);
 
     return iter->second;
 }
+
+std::string_view n2t::Code::destMnemonic(uint16_t dest)
+{
+    throwUnless(dest < destNames.size(), "Invalid 'dest' code ({:#05b})", dest);
+
+    return destNames[dest];
+}
+
+std::string_view n2t::Code::compMnemonic(uint16_t comp)
+{
+    throwUnless((comp < compNames.size()) && !compNames[comp].empty(), "Invalid 'comp' code ({:#09b})", comp);
+
+    return compNames[comp];
+}
+
+std::string_view n2t::Code::jumpMnemonic(uint16_t jump)
+{
+    throwUnless(jump < jumpNames.size(), "Invalid 'jump' code ({:#05b})", jump);
+
+    return jumpNames[jump];
+}
+
+std::optional<uint16_t> n2t::Code::instruction(std::string_view instruction) noexcept
+{
+    if (instruction.size() > CInstruction::maxLength)
+    {
+        return std::nullopt;
+    }
+
+    auto slot = hashInstruction(instruction) % cInstructions.size();
+    while (cInstructions[slot].length != 0)
+    {
+        if (cInstructions[slot].view() == instruction)
+        {
+            return cInstructions[slot].code;
+        }
+        slot = (slot + 1) % cInstructions.size();
+    }
+
+    return std::nullopt;
+}
@@ -26,6 +26,7 @@
 #define N2T_CODE_H
 
 #include <cstdint>
+#include <optional>
 #include <string_view>
 
 namespace n2t
@@ -43,6 +44,21 @@ public:
 
     // Returns the binary code of the 'jump' mnemonic.
     [[nodiscard]] static uint16_t jump(std::string_view jump);
+
+    // Returns the 'dest' mnemonic of the 3-bit binary code, which is empty when no destination is stored.
+    [[nodiscard]] static std::string_view destMnemonic(uint16_t dest);
+
+    // Returns the 'comp' mnemonic of the 7-bit binary code ('a' bit followed by 'c1' to 'c6').
+    [[nodiscard]] static std::string_view compMnemonic(uint16_t comp);
+
+    // Returns the 'jump' mnemonic of the 3-bit binary code, which is empty when no jump is performed.
+    [[nodiscard]] static std::string_view jumpMnemonic(uint16_t jump);
+
+    // Returns the binary code of the whole C-instruction 'dest=comp;jump', using a single lookup in a table of all
+    // valid instructions. Returns no value if the instruction is not found, in which case its mnemonics should be
+    // translated separately, either to report the invalid mnemonic or to accept an unusual form such as an empty
+    // 'dest' followed by '='.
+    [[nodiscard]] static std::optional<uint16_t> instruction(std::string_view instruction) noexcept;
 };
 }  // namespace n2t
 
@@ -0,0 +1,207 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "DisassemblyEngine.h"
+#include "Code.h"
+
+#include <Util.h>
+
+#include <fmt/format.h>
+
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace
+{
+constexpr uint16_t addressBit   = 0x8000;
+constexpr uint16_t cPrefixBits  = 0x6000;
+constexpr uint16_t cPrefixShift = 13;
+constexpr uint16_t compShift    = 6;
+constexpr uint16_t compMask     = 0x7F;
+constexpr uint16_t destShift    = 3;
+constexpr uint16_t fieldMask    = 0b111;
+constexpr uint16_t memoryComp   = 0b1000000;
+constexpr uint16_t memoryDest   = 0b001;
+
+[[nodiscard]] constexpr bool isCInstruction(uint16_t instruction) noexcept
+{
+    return (instruction & addressBit) != 0;
+}
+}  // namespace
+
+n2t::DisassemblyEngine::DisassemblyEngine(std::filesystem::path inputFilename,
+                                          std::filesystem::path outputFilename,
+                                          std::filesystem::path symbolMapFilename) :
+    m_inputFilename{std::move(inputFilename)},
+    m_outputFilename{std::move(outputFilename)},
+    m_symbolMapFilename{std::move(symbolMapFilename)}
+{
+}
+
+n2t::DisassemblyEngine::~DisassemblyEngine() noexcept
+{
+    try
+    {
+        if (!m_disassembled)
+        {
+            std::filesystem::remove(m_outputFilename);
+        }
+    }
+    catch (...)
+    {
+    }
+}
+
+void n2t::DisassemblyEngine::disassemble()
+{
+    throwUnless(!m_disassembled, "Input file ({}) has already been disassembled", m_inputFilename.filename().string());
+
+    const auto instructions = loadRomImage(m_inputFilename);
+    const auto filename     = m_inputFilename.filename().string();
+
+    if (!m_symbolMapFilename.empty())
+    {
+        m_symbolMap = loadSymbolMap(m_symbolMapFilename);
+        for (const auto& entry : m_symbolMap)
+        {
+            if (entry.kind == SymbolKind::Label)
+            {
+                throwUnless(entry.address <= instructions.size(),
+                            "Label ({}) address ({}) is outside of the program",
+                            entry.symbol,
+                            entry.address);
+                m_labels[entry.address].push_back(entry.symbol);
+            }
+            else
+            {
+                m_variables.try_emplace(entry.address, entry.symbol);
+            }
+        }
+    }
+
+    fmt::memory_buffer buffer;
+    auto               out = std::back_inserter(buffer);
+
+    const auto writeLabels = [&](std::size_t address) {
+        if (const auto labels = m_labels.find(static_cast<uint16_t>(address)); labels != m_labels.end())
+        {
+            for (const auto label : labels->second)
+            {
+                fmt::format_to(out, "({})\n", label);
+            }
+        }
+    };
+
+    for (std::size_t address = 0; address < instructions.size(); ++address)
+    {
+        writeLabels(address);
+
+        const auto instruction = instructions[address];
+        if (!isCInstruction(instruction))
+        {
+            const auto* nextInstruction = (address + 1 < instructions.size()) ? &instructions[address + 1] : nullptr;
+            if (const auto symbol = this->symbol(instruction, nextInstruction); !symbol.empty())
+            {
+                fmt::format_to(out, "@{}\n", symbol);
+            }
+            else
+            {
+                fmt::format_to(out, "@{}\n", instruction);
+            }
+            continue;
+        }
+
+        const SourceLocation location{filename, static_cast<unsigned int>(address + 1)};
+
+        std::string_view dest;
+        std::string_view comp;
+        std::string_view jump;
+        try
+        {
+            dest = Code::destMnemonic((instruction >> destShift) & fieldMask);
+            comp = Code::compMnemonic((instruction >> compShift) & compMask);
+            jump = Code::jumpMnemonic(instruction & fieldMask);
+        }
+        catch (const std::exception& ex)
+        {
+            throwAlways(location, "{}", ex.what());
+        }
+
+        if (!dest.empty())
+        {
+            fmt::format_to(out, "{}=", dest);
+        }
+        fmt::format_to(out, "{}", comp);
+        if (!jump.empty())
+        {
+            fmt::format_to(out, ";{}", jump);
+        }
+
+        // the CPU ignores bits 14-13, which other toolchains may not set, but reassembling the instruction sets them
+        if ((instruction & cPrefixBits) != cPrefixBits)
+        {
+            fmt::format_to(out,
+                           "  // {:016b}: bits 14-13 ({:02b}) are ignored",
+                           instruction,
+                           (instruction & cPrefixBits) >> cPrefixShift);
+        }
+        buffer.push_back('\n');
+    }
+    writeLabels(instructions.size());
+
+    std::ofstream file{m_outputFilename};
+    throwUnless<std::runtime_error>(file.good(), "Could not open output file ({})", m_outputFilename.string());
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    throwUnless<std::runtime_error>(file.good(), "Could not write output file ({})", m_outputFilename.string());
+
+    m_disassembled = true;
+}
+
+std::string_view n2t::DisassemblyEngine::symbol(uint16_t value, const uint16_t* nextInstruction) const
+{
+    if ((nextInstruction == nullptr) || !isCInstruction(*nextInstruction))
+    {
+        return {};
+    }
+
+    if ((*nextInstruction & fieldMask) != 0)
+    {
+        const auto labels = m_labels.find(value);
+        return (labels != m_labels.end()) ? labels->second.front() : std::string_view{};
+    }
+
+    const auto usesMemory = (((*nextInstruction >> compShift) & memoryComp) != 0) ||
+                            (((*nextInstruction >> destShift) & memoryDest) != 0);
+    if (usesMemory)
+    {
+        const auto variable = m_variables.find(value);
+        return (variable != m_variables.end()) ? variable->second : std::string_view{};
+    }
+
+    return {};
+}
@@ -0,0 +1,73 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef N2T_DISASSEMBLY_ENGINE_H
+#define N2T_DISASSEMBLY_ENGINE_H
+
+#include <RomImage.h>
+#include <SymbolMap.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace n2t
+{
+class DisassemblyEngine
+{
+public:
+    // The optional symbol map is used to replace the addresses of labels and variables with their symbols.
+    DisassemblyEngine(std::filesystem::path inputFilename,
+                      std::filesystem::path outputFilename,
+                      std::filesystem::path symbolMapFilename = {});
+
+    DisassemblyEngine(const DisassemblyEngine&) = delete;
+    DisassemblyEngine(DisassemblyEngine&&)      = delete;
+
+    DisassemblyEngine& operator=(const DisassemblyEngine&) = delete;
+    DisassemblyEngine& operator=(DisassemblyEngine&&) = delete;
+
+    ~DisassemblyEngine() noexcept;
+
+    void disassemble();
+
+private:
+    // Returns the symbol of an A-instruction value, based on how the value is used by the next instruction:
+    // a jump target is a label, and an address of the data memory is a variable. Returns an empty symbol if the
+    // value should be kept as a number.
+    [[nodiscard]] std::string_view symbol(uint16_t value, const uint16_t* nextInstruction) const;
+
+    std::filesystem::path                                       m_inputFilename;
+    std::filesystem::path                                       m_outputFilename;
+    std::filesystem::path                                       m_symbolMapFilename;
+    SymbolMap                                                   m_symbolMap;
+    std::unordered_map<uint16_t, std::vector<std::string_view>> m_labels;
+    std::unordered_map<uint16_t, std::string_view>              m_variables;
+    bool                                                        m_disassembled = false;
+};
+}  // namespace n2t
+
+#endif
@@ -26,35 +26,53 @@
 
 #include <Util.h>
 
-#include <boost/algorithm/string/classification.hpp>
-
 #include <algorithm>
 
-n2t::Parser::Parser(const std::filesystem::path& filename) : m_file{filename}
+namespace
+{
+[[nodiscard]] constexpr bool isSpace(char c) noexcept
+{
+    return ((c == ' ') || (c == '\t') || (c == '\n') || (c == '\v') || (c == '\f') || (c == '\r'));
+}
+}  // namespace
+
+n2t::Parser::Parser(std::string_view text) : m_text{text}
 {
-    throwUnless<std::runtime_error>(m_file.good(), "Could not open input file ({})", filename.string());
 }
 
 bool n2t::Parser::advance()
 {
-    std::string currentCommand;
-    while (currentCommand.empty() && std::getline(m_file, currentCommand))
+    std::string_view currentCommand;
+    while (currentCommand.empty() && (m_position < m_text.size()))
     {
         ++m_lineNumber;
 
+        const auto lineEnd = std::min(m_text.find('\n', m_position), m_text.size());
+        currentCommand     = m_text.substr(m_position, lineEnd - m_position);
+        m_position         = lineEnd + 1;
+
         const auto commentPos = currentCommand.find("//");
-        if (commentPos != std::string::npos)
+        if (commentPos != std::string_view::npos)
         {
-            currentCommand.erase(commentPos);
+            currentCommand.remove_suffix(currentCommand.size() - commentPos);
+        }
+
+        const auto first = std::find_if_not(currentCommand.begin(), currentCommand.end(), isSpace);
+        const auto last  = std::find_if_not(currentCommand.rbegin(), currentCommand.rend(), isSpace).base();
+        currentCommand   = (first < last) ? std::string_view{first, last} : std::string_view{};
+
+        if (std::any_of(currentCommand.begin(), currentCommand.end(), isSpace))
+        {
+            currentCommand = compactCommand(currentCommand);
         }
-        currentCommand.erase(std::remove_if(currentCommand.begin(), currentCommand.end(), boost::algorithm::is_space()),
-                             currentCommand.end());
     }
     if (currentCommand.empty())
     {
         return false;
     }
 
+    m_command = currentCommand;
+
     if (currentCommand.front() == '@')
     {
         throwUnless(currentCommand.length() != 1, "Address or symbol not specified in addressing instruction");
@@ -74,35 +92,6 @@ bool n2t::Parser::advance()
     else
     {
         m_commandType = CommandType::C;
-
-        auto equalsignPos = currentCommand.find('=');
-        auto semicolonPos = currentCommand.find(';');
-
-        m_dest.clear();
-        if (equalsignPos != std::string::npos)
-        {
-            m_dest = currentCommand.substr(/* __pos = */ 0, equalsignPos);
-        }
-
-        m_jump.clear();
-        if (semicolonPos != std::string::npos)
-        {
-            m_jump = currentCommand.substr(semicolonPos + 1);
-        }
-
-        if (equalsignPos == std::string::npos)
-        {
-            equalsignPos = 0;
-        }
-        else
-        {
-            ++equalsignPos;
-        }
-        if (semicolonPos != std::string::npos)
-        {
-            semicolonPos -= equalsignPos;
-        }
-        m_comp = currentCommand.substr(equalsignPos, semicolonPos);
     }
 
     return true;
@@ -113,22 +102,61 @@ n2t::CommandType n2t::Parser::commandType() const
     return m_commandType;
 }
 
-const std::string& n2t::Parser::symbol() const
+std::string_view n2t::Parser::symbol() const
 {
     return m_symbol;
 }
 
-const std::string& n2t::Parser::dest() const
+std::string_view n2t::Parser::command() const
 {
-    return m_dest;
+    return m_command;
 }
 
-const std::string& n2t::Parser::comp() const
+std::string_view n2t::Parser::dest() const
 {
-    return m_comp;
+    const auto equalsignPos = m_command.find('=');
+    if (equalsignPos == std::string_view::npos)
+    {
+        return {};
+    }
+    return m_command.substr(/* __pos = */ 0, equalsignPos);
+}
+
+std::string_view n2t::Parser::comp() const
+{
+    auto equalsignPos = m_command.find('=');
+    auto semicolonPos = m_command.find(';');
+
+    if (equalsignPos == std::string_view::npos)
+    {
+        equalsignPos = 0;
+    }
+    else
+    {
+        ++equalsignPos;
+    }
+    if (semicolonPos != std::string_view::npos)
+    {
+        semicolonPos -= equalsignPos;
+    }
+    return m_command.substr(equalsignPos, semicolonPos);
+}
+
+std::string_view n2t::Parser::jump() const
+{
+    const auto semicolonPos = m_command.find(';');
+    if (semicolonPos == std::string_view::npos)
+    {
+        return {};
+    }
+    return m_command.substr(semicolonPos + 1);
 }
 
-const std::string& n2t::Parser::jump() const
+std::string_view n2t::Parser::compactCommand(std::string_view command)
 {
-    return m_jump;
+    // commands with embedded whitespace are rare, so they are copied into storage that never invalidates
+    // previously returned views rather than into a reusable buffer
+    auto& compact = m_compactCommands.emplace_back(command);
+    compact.erase(std::remove_if(compact.begin(), compact.end(), isSpace), compact.end());
+    return compact;
 }
@@ -25,10 +25,11 @@
 #ifndef N2T_PARSER_H
 #define N2T_PARSER_H
 
+#include <cstddef>
 #include <cstdint>
-#include <filesystem>
-#include <fstream>
+#include <deque>
 #include <string>
+#include <string_view>
 
 namespace n2t
 {
@@ -39,11 +40,21 @@ enum class CommandType
     L   // (Xxx)
 };
 
+// The views returned by the parser refer either directly to the input text or to storage owned by the parser,
+// and remain valid for the lifetime of both.
 class Parser
 {
 public:
-    // Opens the input file and gets ready to parse it.
-    explicit Parser(const std::filesystem::path& filename);
+    // Gets ready to parse the input text, typically the contents of a memory-mapped file.
+    explicit Parser(std::string_view text);
+
+    Parser(const Parser&) = delete;
+    Parser(Parser&&)      = delete;
+
+    Parser& operator=(const Parser&) = delete;
+    Parser& operator=(Parser&&) = delete;
+
+    ~Parser() = default;
 
     // Returns the current line number.
     [[nodiscard]] unsigned int lineNumber() const
@@ -57,30 +68,38 @@ public:
     // Returns the type of the current command.
     [[nodiscard]] CommandType commandType() const;
 
+    // Returns the current command without comments and whitespace.
+    [[nodiscard]] std::string_view command() const;
+
     // Returns the symbol or decimal Xxx of the current command @Xxx or (Xxx).
     // Should be called only when commandType() is CommandType::A or CommandType::L.
-    [[nodiscard]] const std::string& symbol() const;
+    [[nodiscard]] std::string_view symbol() const;
+
+    // The following functions split the current C-command into its mnemonics on demand.
 
     // Returns the 'dest' mnemonic in the current C-command (8 possibilities).
     // Should be called only when commandType() is CommandType::C.
-    [[nodiscard]] const std::string& dest() const;
+    [[nodiscard]] std::string_view dest() const;
 
     // Returns the 'comp' mnemonic in the current C-command (28 possibilities).
     // Should be called only when commandType() is CommandType::C.
-    [[nodiscard]] const std::string& comp() const;
+    [[nodiscard]] std::string_view comp() const;
 
     // Returns the 'jump' mnemonic in the current C-command (8 possibilities).
     // Should be called only when commandType() is CommandType::C.
-    [[nodiscard]] const std::string& jump() const;
+    [[nodiscard]] std::string_view jump() const;
 
 private:
-    std::ifstream m_file;
-    unsigned int  m_lineNumber  = 0;
-    CommandType   m_commandType = CommandType::A;
-    std::string   m_symbol;
-    std::string   m_dest;
-    std::string   m_comp;
-    std::string   m_jump;
+    // Returns the current command with all of its embedded whitespace removed.
+    [[nodiscard]] std::string_view compactCommand(std::string_view command);
+
+    std::string_view        m_text;
+    std::size_t             m_position = 0;
+    std::deque<std::string> m_compactCommands;
+    unsigned int            m_lineNumber  = 0;
+    CommandType             m_commandType = CommandType::A;
+    std::string_view        m_command;
+    std::string_view        m_symbol;
 };
 }  // namespace n2t
 
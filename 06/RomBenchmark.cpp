@@ -0,0 +1,182 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <RomImage.h>
+#include <Util.h>
+
+#include <cxxopts.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+constexpr std::size_t wordBits = 16;
+
+// Writes a text ROM image one instruction at a time through std::bitset, as the assembler did before the buffered
+// emitter, to serve as the baseline.
+void saveBitsetImage(const std::filesystem::path& filename, std::span<const uint16_t> instructions)
+{
+    std::ofstream file{filename};
+    n2t::throwUnless<std::runtime_error>(file.good(), "Could not open output file ({})", filename.string());
+
+    for (const auto instruction : instructions)
+    {
+        file << std::bitset<wordBits>(instruction) << '\n';
+    }
+}
+
+// Returns the shortest time of 'repetitions' runs of 'write', in seconds.
+[[nodiscard]] double measure(unsigned int repetitions, const std::function<void()>& write)
+{
+    auto best = std::numeric_limits<double>::max();
+    for (unsigned int run = 0; run < repetitions; ++run)
+    {
+        const auto startTime = std::chrono::steady_clock::now();
+        write();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+    }
+    return best;
+}
+
+[[nodiscard]] std::string readFile(const std::filesystem::path& filename)
+{
+    std::ifstream file{filename, std::ios::binary};
+    return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    int result = EXIT_SUCCESS;
+
+    const std::filesystem::path programPath{*argv};
+    cxxopts::Options            options{programPath.filename(), "ROM Image Writer Benchmark"};
+
+    try
+    {
+        /*
+         * Parse command line options
+         */
+
+        std::size_t           count       = 0;
+        unsigned int          repetitions = 0;
+        std::filesystem::path directory;
+
+        // clang-format off
+        options.add_options()
+            ("help", "Display this help message")
+            ("d,directory", "Directory of the written files", cxxopts::value<std::filesystem::path>(directory)->default_value(std::filesystem::temp_directory_path().string()))
+            ("n,instructions", "Number of random instructions", cxxopts::value<std::size_t>(count)->default_value("1000000"))
+            ("r,repetitions", "Number of runs of each writer, of which the fastest is reported", cxxopts::value<unsigned int>(repetitions)->default_value("5"));
+        // clang-format on
+
+        const auto optionsMap = options.parse(argc, argv);
+
+        if (optionsMap.count("help") != 0)
+        {
+            std::cout << options.help() << '\n';
+            return EXIT_SUCCESS;
+        }
+
+        if (repetitions == 0)
+        {
+            throw cxxopts::OptionParseException{"Option 'repetitions' must be positive"};
+        }
+
+        /*
+         * Run benchmark
+         */
+
+        // fixed seed, so that every run writes the same files
+        std::mt19937                            engine{0x4E325431};
+        std::uniform_int_distribution<uint16_t> distribution;
+        std::vector<uint16_t>                   instructions(count);
+        std::generate(instructions.begin(), instructions.end(), [&] { return distribution(engine); });
+
+        const auto bitsetFilename = directory / "RomBenchmark.bitset.hack";
+        const auto textFilename   = directory / "RomBenchmark.text.hack";
+        const auto binaryFilename = directory / "RomBenchmark.bin.hack";
+
+        const auto bitsetTime = measure(repetitions, [&] { saveBitsetImage(bitsetFilename, instructions); });
+        const auto textTime = measure(repetitions, [&] {
+            n2t::saveRomImage(textFilename, instructions, n2t::RomFormat::Text);
+        });
+        const auto binaryTime = measure(repetitions, [&] {
+            n2t::saveRomImage(binaryFilename, instructions, n2t::RomFormat::Binary);
+        });
+
+        const auto identical = (readFile(bitsetFilename) == readFile(textFilename));
+        std::filesystem::remove(bitsetFilename);
+        std::filesystem::remove(textFilename);
+        std::filesystem::remove(binaryFilename);
+
+        const auto rate = [&](double seconds) {
+            return (seconds > 0) ? (static_cast<double>(count) / seconds / 1e6) : 0.0;
+        };
+
+        std::cout << fmt::format("Wrote {} instructions, fastest of {} runs\n", count, repetitions);
+        std::cout << fmt::format("  bitset  {:8.1f} ms  {:7.1f} M instructions/s\n",
+                                 bitsetTime * 1e3,
+                                 rate(bitsetTime));
+        std::cout << fmt::format("  text    {:8.1f} ms  {:7.1f} M instructions/s  ({:.1f}x)\n",
+                                 textTime * 1e3,
+                                 rate(textTime),
+                                 (textTime > 0) ? (bitsetTime / textTime) : 0.0);
+        std::cout << fmt::format("  binary  {:8.1f} ms  {:7.1f} M instructions/s  ({:.1f}x)\n",
+                                 binaryTime * 1e3,
+                                 rate(binaryTime),
+                                 (binaryTime > 0) ? (bitsetTime / binaryTime) : 0.0);
+
+        n2t::throwUnless<std::runtime_error>(identical, "Text output differs from the bitset output");
+    }
+    catch (const cxxopts::OptionException& ex)
+    {
+        result = EXIT_FAILURE;
+        std::cerr << "ERROR: " << ex.what() << "\n\n";
+        std::cout << options.help() << '\n';
+    }
+    catch (const std::exception& ex)
+    {
+        result = EXIT_FAILURE;
+        std::cerr << "ERROR: " << ex.what() << '\n';
+    }
+
+    return result;
+}
@@ -28,38 +28,87 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
+
+namespace
+{
+constexpr std::size_t initialBucketCount  = 1024;
+constexpr std::size_t symbolBlockCapacity = 64 * 1024;
+}  // namespace
+
 n2t::SymbolTable::SymbolTable()
 {
+    m_table.reserve(initialBucketCount);
+
     // initialize the table with the predefined symbols
     const int16_t numNamedRamLocations = 16;
     for (int16_t i = 0; i < numNamedRamLocations; ++i)
     {
-        m_table[fmt::format("R{}", i)] = i;
+        addEntry(fmt::format("R{}", i), i);
     }
 
-    m_table["SP"]     = 0x0000;
-    m_table["LCL"]    = 0x0001;
-    m_table["ARG"]    = 0x0002;
-    m_table["THIS"]   = 0x0003;
-    m_table["THAT"]   = 0x0004;
-    m_table["SCREEN"] = 0x4000;  // NOLINT(readability-magic-numbers)
-    m_table["KBD"]    = 0x6000;  // NOLINT(readability-magic-numbers)
+    addEntry("SP", 0x0000);
+    addEntry("LCL", 0x0001);
+    addEntry("ARG", 0x0002);
+    addEntry("THIS", 0x0003);
+    addEntry("THAT", 0x0004);
+    addEntry("SCREEN", 0x4000);  // NOLINT(readability-magic-numbers)
+    addEntry("KBD", 0x6000);     // NOLINT(readability-magic-numbers)
 }
 
-void n2t::SymbolTable::addEntry(const std::string& symbol, int16_t address)
+void n2t::SymbolTable::addEntry(std::string_view symbol, int16_t address)
 {
-    throwUnless(m_table.emplace(symbol, address).second, "Symbol ({}) already exists in the table", symbol);
+    throwUnless(getOrAddEntry(symbol, address).second, "Symbol ({}) already exists in the table", symbol);
 }
 
-bool n2t::SymbolTable::contains(const std::string& symbol) const
+std::pair<int16_t, bool> n2t::SymbolTable::getOrAddEntry(std::string_view symbol, int16_t address)
+{
+    const auto iter = m_table.find(symbol);
+    if (iter != m_table.end())
+    {
+        return {iter->second, false};
+    }
+
+    m_table.emplace(storeSymbol(symbol), address);
+    return {address, true};
+}
+
+bool n2t::SymbolTable::contains(std::string_view symbol) const
 {
     return (m_table.find(symbol) != m_table.end());
 }
 
-int16_t n2t::SymbolTable::getAddress(const std::string& symbol) const
+int16_t n2t::SymbolTable::getAddress(std::string_view symbol) const
 {
     const auto iter = m_table.find(symbol);
     throwUnless(iter != m_table.end(), "Symbol ({}) not found in the table", symbol);
 
     return iter->second;
 }
+
+std::optional<int16_t> n2t::SymbolTable::findAddress(std::string_view symbol) const
+{
+    const auto iter = m_table.find(symbol);
+    if (iter == m_table.end())
+    {
+        return std::nullopt;
+    }
+
+    return iter->second;
+}
+
+std::string_view n2t::SymbolTable::storeSymbol(std::string_view symbol)
+{
+    if (m_symbolBlocks.empty() || ((m_symbolBlockSize + symbol.size()) > symbolBlockCapacity))
+    {
+        // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays)
+        m_symbolBlocks.push_back(std::make_unique<char[]>(std::max(symbolBlockCapacity, symbol.size())));
+        m_symbolBlockSize = 0;
+    }
+
+    auto* storedSymbol = m_symbolBlocks.back().get() + m_symbolBlockSize;
+    std::copy(symbol.begin(), symbol.end(), storedSymbol);
+    m_symbolBlockSize += symbol.size();
+
+    return {storedSymbol, symbol.size()};
+}
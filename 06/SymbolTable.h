@@ -25,9 +25,14 @@
 #ifndef N2T_SYMBOL_TABLE_H
 #define N2T_SYMBOL_TABLE_H
 
+#include <cstddef>
 #include <cstdint>
-#include <string>
+#include <memory>
+#include <optional>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace n2t
 {
@@ -37,17 +42,37 @@ public:
     // Creates a new symbol table and adds the predefined symbols to it.
     SymbolTable();
 
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable(SymbolTable&&)      = default;
+
+    SymbolTable& operator=(const SymbolTable&) = delete;
+    SymbolTable& operator=(SymbolTable&&) = default;
+
+    ~SymbolTable() = default;
+
     // Adds the pair (symbol, address) to the table.
-    void addEntry(const std::string& symbol, int16_t address);
+    void addEntry(std::string_view symbol, int16_t address);
+
+    // Returns the address associated with the symbol, after adding the pair (symbol, address) to the table if it
+    // does not contain the symbol, together with whether the pair was added.
+    [[nodiscard]] std::pair<int16_t, bool> getOrAddEntry(std::string_view symbol, int16_t address);
 
     // Does the symbol table contain the given symbol?
-    [[nodiscard]] bool contains(const std::string& symbol) const;
+    [[nodiscard]] bool contains(std::string_view symbol) const;
 
     // Returns the address associated with the symbol.
-    [[nodiscard]] int16_t getAddress(const std::string& symbol) const;
+    [[nodiscard]] int16_t getAddress(std::string_view symbol) const;
+
+    // Returns the address associated with the symbol, if the table contains it.
+    [[nodiscard]] std::optional<int16_t> findAddress(std::string_view symbol) const;
 
 private:
-    std::unordered_map<std::string, int16_t> m_table;
+    // Copies the symbol into arena storage, which keeps its address when more symbols are added.
+    [[nodiscard]] std::string_view storeSymbol(std::string_view symbol);
+
+    std::unordered_map<std::string_view, int16_t> m_table;
+    std::vector<std::unique_ptr<char[]>>          m_symbolBlocks;  // NOLINT(cppcoreguidelines-avoid-c-arrays)
+    std::size_t                                   m_symbolBlockSize = 0;
 };
 }  // namespace n2t
 
@@ -0,0 +1,671 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "NativeOs.h"
+
+#include <Util.h>
+
+#include <algorithm>
+
+namespace
+{
+constexpr uint16_t addressMask   = 0x7FFF;
+constexpr uint16_t jackTrue      = 0xFFFF;
+constexpr uint16_t screen        = 0x4000;
+constexpr uint16_t newLineChar   = 128;
+constexpr uint16_t backSpaceChar = 129;
+
+// The free list is searched at most once per free segment, which cannot exceed the RAM size.
+constexpr std::size_t maxFreeSegments = 0x8000;
+
+// The divisors double until they exceed the dividend or overflow, which takes at most 16 steps.
+constexpr std::size_t maxDivisors = 32;
+
+// Comparisons of the VM commands 'lt' and 'gt', which compare the 16-bit difference of their operands.
+[[nodiscard]] constexpr bool less(uint16_t x, uint16_t y)
+{
+    return static_cast<int16_t>(x - y) < 0;
+}
+
+[[nodiscard]] constexpr bool greater(uint16_t x, uint16_t y)
+{
+    return static_cast<int16_t>(x - y) > 0;
+}
+
+// A Jack condition holds only if it is true (-1), as the compiled code branches on its complement.
+[[nodiscard]] constexpr bool holds(uint16_t condition)
+{
+    return condition == jackTrue;
+}
+
+[[nodiscard]] constexpr uint16_t abs(uint16_t x)
+{
+    return less(x, 0) ? static_cast<uint16_t>(-x) : x;
+}
+
+[[nodiscard]] constexpr uint16_t mask(auto... variables)
+{
+    return static_cast<uint16_t>(((1U << variables) | ...));
+}
+
+[[nodiscard]] std::optional<uint16_t> voidResult(bool executed)
+{
+    return executed ? std::optional<uint16_t>{0} : std::nullopt;
+}
+}  // namespace
+
+std::span<const n2t::NativeOs::FunctionInfo> n2t::NativeOs::functions()
+{
+    constexpr auto mathStatics   = mask(MathPowersOfTwo, MathDivisors);
+    constexpr auto screenStatics = mask(ScreenColor, ScreenPowersOfTwo, MemoryMemory) | mathStatics;
+    constexpr auto outputStatics =
+        mask(OutputCharMaps, OutputShiftedCharRows, OutputCursorRow, OutputCursorColumn, OutputEvenCursorColumn) |
+        mask(MemoryMemory);
+
+    // clang-format off
+    static constexpr auto infos = std::array
+    {
+        FunctionInfo{"Math.abs",             Function::MathAbs,             1, 0},
+        FunctionInfo{"Math.multiply",        Function::MathMultiply,        2, mask(MathPowersOfTwo)},
+        FunctionInfo{"Math.divide",          Function::MathDivide,          2, mask(MathDivisors)},
+        FunctionInfo{"Math.sqrt",            Function::MathSqrt,            1, mask(MathPowersOfTwo)},
+        FunctionInfo{"Math.max",             Function::MathMax,             2, 0},
+        FunctionInfo{"Math.min",             Function::MathMin,             2, 0},
+        FunctionInfo{"Memory.peek",          Function::MemoryPeek,          1, mask(MemoryMemory)},
+        FunctionInfo{"Memory.poke",          Function::MemoryPoke,          2, mask(MemoryMemory)},
+        FunctionInfo{"Memory.alloc",         Function::MemoryAlloc,         1, mask(MemoryFreeList)},
+        FunctionInfo{"Memory.deAlloc",       Function::MemoryDeAlloc,       1, mask(MemoryFreeList)},
+        FunctionInfo{"Screen.clearScreen",   Function::ScreenClearScreen,   0, screenStatics},
+        FunctionInfo{"Screen.setColor",      Function::ScreenSetColor,      1, mask(ScreenColor)},
+        FunctionInfo{"Screen.drawPixel",     Function::ScreenDrawPixel,     2, screenStatics},
+        FunctionInfo{"Screen.drawLine",      Function::ScreenDrawLine,      4, screenStatics},
+        FunctionInfo{"Screen.drawRectangle", Function::ScreenDrawRectangle, 4, screenStatics},
+        FunctionInfo{"Screen.drawCircle",    Function::ScreenDrawCircle,    3, screenStatics},
+        FunctionInfo{"Screen.updateWord",    Function::ScreenUpdateWord,    2, mask(ScreenColor, MemoryMemory)},
+        FunctionInfo{"Output.moveCursor",    Function::OutputMoveCursor,    2, outputStatics | mathStatics},
+        FunctionInfo{"Output.printChar",     Function::OutputPrintChar,     1, outputStatics},
+        FunctionInfo{"Output.println",       Function::OutputPrintln,       0, outputStatics},
+        FunctionInfo{"Output.backSpace",     Function::OutputBackSpace,     0, outputStatics},
+        FunctionInfo{"Output.drawChar",      Function::OutputDrawChar,      1, outputStatics},
+        FunctionInfo{"Output.getMap",        Function::OutputGetMap,        1, mask(OutputCharMaps)}
+    };
+    // clang-format on
+
+    return infos;
+}
+
+const n2t::NativeOs::FunctionInfo* n2t::NativeOs::findFunction(std::string_view name)
+{
+    const auto infos = functions();
+    const auto iter  = std::find_if(infos.begin(), infos.end(), [name](const FunctionInfo& info) {
+        return info.name == name;
+    });
+    return (iter != infos.end()) ? &*iter : nullptr;
+}
+
+void n2t::NativeOs::resolveStatics(const FunctionInfo&                               function,
+                                   const std::unordered_map<std::string, uint16_t>& statics)
+{
+    // clang-format off
+    static constexpr auto names = std::array<std::string_view, NumStatics>
+    {
+        "Math.0",
+        "Math.1",
+        "Memory.0",
+        "Memory.1",
+        "Screen.0",
+        "Screen.1",
+        "Output.0",
+        "Output.1",
+        "Output.2",
+        "Output.3",
+        "Output.4"
+    };
+    // clang-format on
+
+    for (uint16_t variable = 0; variable < NumStatics; ++variable)
+    {
+        if ((function.statics & mask(variable)) != 0)
+        {
+            const auto iter = statics.find(std::string{names[variable]});
+            throwUnless(iter != statics.end(),
+                        "Native function ({}) uses static variable ({}), which is not defined",
+                        function.name,
+                        names[variable]);
+            m_statics[variable] = iter->second;
+        }
+    }
+}
+
+std::optional<uint16_t> n2t::NativeOs::call(Function function, uint16_t* ram, const uint16_t* arguments)
+{
+    m_ram = ram;
+
+    const auto* a = arguments;
+    switch (function)
+    {
+        case Function::MathAbs:
+            return abs(a[0]);
+
+        case Function::MathMultiply:
+            return multiply(a[0], a[1]);
+
+        case Function::MathDivide:
+            return divide(a[0], a[1]);
+
+        case Function::MathSqrt:
+            return sqrt(a[0]);
+
+        case Function::MathMax:
+            return greater(a[0], a[1]) ? a[0] : a[1];
+
+        case Function::MathMin:
+            return less(a[0], a[1]) ? a[0] : a[1];
+
+        case Function::MemoryPeek:
+            return peek(a[0]);
+
+        case Function::MemoryPoke:
+            poke(a[0], a[1]);
+            return 0;
+
+        case Function::MemoryAlloc:
+            return alloc(a[0]);
+
+        case Function::MemoryDeAlloc:
+            deAlloc(a[0]);
+            return 0;
+
+        case Function::ScreenClearScreen:
+            clearScreen();
+            return 0;
+
+        case Function::ScreenSetColor:
+            variable(ScreenColor) = a[0];
+            return 0;
+
+        case Function::ScreenDrawPixel:
+            return voidResult(drawPixel(a[0], a[1]));
+
+        case Function::ScreenDrawLine:
+            return voidResult(drawLine(a[0], a[1], a[2], a[3]));
+
+        case Function::ScreenDrawRectangle:
+            return voidResult(drawRectangle(a[0], a[1], a[2], a[3]));
+
+        case Function::ScreenDrawCircle:
+            return voidResult(drawCircle(a[0], a[1], a[2]));
+
+        case Function::ScreenUpdateWord:
+            updateWord(a[0], a[1]);
+            return 0;
+
+        case Function::OutputMoveCursor:
+            return voidResult(moveCursor(a[0], a[1]));
+
+        case Function::OutputPrintChar:
+            printChar(a[0]);
+            return 0;
+
+        case Function::OutputPrintln:
+            println();
+            return 0;
+
+        case Function::OutputBackSpace:
+            backSpace();
+            return 0;
+
+        case Function::OutputDrawChar:
+            drawChar(a[0]);
+            return 0;
+
+        case Function::OutputGetMap:
+            return getMap(a[0]);
+    }
+
+    return std::nullopt;
+}
+
+uint16_t& n2t::NativeOs::element(uint16_t base, uint16_t index)
+{
+    return m_ram[static_cast<uint16_t>(base + index) & addressMask];
+}
+
+uint16_t n2t::NativeOs::multiply(uint16_t x, uint16_t y)
+{
+    const auto powersOfTwo = variable(MathPowersOfTwo);
+
+    uint16_t sum = 0;
+    for (uint16_t i = 0; i < 16; ++i)
+    {
+        if ((y & element(powersOfTwo, i)) != 0)
+        {
+            sum = static_cast<uint16_t>(sum + x);
+        }
+        x = static_cast<uint16_t>(x + x);
+    }
+    return sum;
+}
+
+std::optional<uint16_t> n2t::NativeOs::divide(uint16_t x, uint16_t y)
+{
+    if (y == 0)
+    {
+        return std::nullopt;
+    }
+
+    const auto negative = (less(x, 0) && greater(y, 0)) || (greater(x, 0) && less(y, 0));
+    x                   = abs(x);
+    y                   = abs(y);
+
+    // the divisors are computed before they are stored, so that nothing is changed if there are too many of them
+    std::array<uint16_t, maxDivisors> divisors{};
+    std::size_t                       count = 0;
+    for (auto done = false; !done; ++count)
+    {
+        if (count == divisors.size())
+        {
+            return std::nullopt;
+        }
+        done            = less(static_cast<uint16_t>(32767 - y), y) || !less(y, x);
+        divisors[count] = y;
+        y               = static_cast<uint16_t>(y + y);
+    }
+
+    const auto array = variable(MathDivisors);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        element(array, static_cast<uint16_t>(i)) = divisors[i];
+    }
+
+    uint16_t value    = 0;
+    uint16_t quotient = 0;
+    for (auto i = static_cast<uint16_t>(count); i-- > 0;)
+    {
+        const auto divisor = element(array, i);
+        if (less(static_cast<uint16_t>(x - value), divisor))
+        {
+            quotient = static_cast<uint16_t>(quotient + quotient);
+        }
+        else
+        {
+            quotient = static_cast<uint16_t>(quotient + quotient + 1);
+            value    = static_cast<uint16_t>(value + divisor);
+        }
+    }
+    return negative ? static_cast<uint16_t>(-quotient) : quotient;
+}
+
+std::optional<uint16_t> n2t::NativeOs::sqrt(uint16_t x)
+{
+    if (less(x, 0))
+    {
+        return std::nullopt;
+    }
+
+    uint16_t root = 0;
+    for (uint16_t i = 8; i-- > 0;)
+    {
+        const auto value   = static_cast<uint16_t>(root + element(variable(MathPowersOfTwo), i));
+        const auto squared = multiply(value, value);
+        if (!greater(squared, x) && greater(squared, 0))
+        {
+            root = value;
+        }
+    }
+    return root;
+}
+
+uint16_t n2t::NativeOs::peek(uint16_t address)
+{
+    return element(variable(MemoryMemory), address);
+}
+
+void n2t::NativeOs::poke(uint16_t address, uint16_t value)
+{
+    element(variable(MemoryMemory), address) = value;
+}
+
+std::optional<uint16_t> n2t::NativeOs::alloc(uint16_t size)
+{
+    if (!greater(size, 0))
+    {
+        return std::nullopt;
+    }
+
+    // first fit, searched before anything is changed
+    uint16_t segment = 0;
+    uint16_t prev    = 0;
+    uint16_t curr    = variable(MemoryFreeList);
+    for (std::size_t searched = 0; (segment == 0) && (curr != 0); ++searched)
+    {
+        if (searched == maxFreeSegments)
+        {
+            return std::nullopt;
+        }
+
+        if (greater(element(curr, 0), size))
+        {
+            segment = curr;
+        }
+        else
+        {
+            prev = curr;
+            curr = element(curr, 1);
+        }
+    }
+    if (segment == 0)
+    {
+        return std::nullopt;
+    }
+
+    uint16_t   block     = 0;
+    const auto remainder = static_cast<uint16_t>(element(segment, 0) - (size + 1));
+    if (less(remainder, 2))
+    {
+        block = static_cast<uint16_t>(segment + 1);
+        if (prev == 0)
+        {
+            variable(MemoryFreeList) = element(segment, 1);
+        }
+        else
+        {
+            element(prev, 1) = element(segment, 1);
+        }
+    }
+    else
+    {
+        block                  = static_cast<uint16_t>(segment + 1 + remainder);
+        element(block, 0xFFFF) = static_cast<uint16_t>(size + 1);
+        element(segment, 0)    = remainder;
+    }
+    return block;
+}
+
+void n2t::NativeOs::deAlloc(uint16_t object)
+{
+    const auto segment       = static_cast<uint16_t>(object - 1);
+    element(segment, 1)      = variable(MemoryFreeList);
+    variable(MemoryFreeList) = segment;
+}
+
+void n2t::NativeOs::clearScreen()
+{
+    const auto color      = variable(ScreenColor);
+    variable(ScreenColor) = 0;
+    static_cast<void>(drawRectangle(0, 0, 511, 255));
+    variable(ScreenColor) = color;
+}
+
+bool n2t::NativeOs::drawPixel(uint16_t x, uint16_t y)
+{
+    if (less(x, 0) || greater(x, 511) || less(y, 0) || greater(y, 255))
+    {
+        return false;
+    }
+
+    const auto row     = multiply(y, 32);
+    const auto address = static_cast<uint16_t>(screen + row + *divide(x, 16));
+    updateWord(address, element(variable(ScreenPowersOfTwo), x & 15));
+    return true;
+}
+
+bool n2t::NativeOs::drawLine(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)
+{
+    if (less(x1, 0) || greater(x1, 511) || less(y1, 0) || greater(y1, 255) || less(x2, 0) || greater(x2, 511) ||
+        less(y2, 0) || greater(y2, 255))
+    {
+        return false;
+    }
+
+    if (y1 == y2)
+    {
+        return less(x1, x2) ? drawRectangle(x1, y1, x2, y2) : drawRectangle(x2, y2, x1, y1);
+    }
+
+    const auto sx = less(x1, x2) ? uint16_t{1} : uint16_t{0xFFFF};
+    const auto sy = less(y1, y2) ? uint16_t{1} : uint16_t{0xFFFF};
+
+    static_cast<void>(drawPixel(x1, y1));
+    if (x1 == x2)
+    {
+        while (y1 != y2)
+        {
+            y1 = static_cast<uint16_t>(y1 + sy);
+            static_cast<void>(drawPixel(x1, y1));
+        }
+        return true;
+    }
+
+    const auto dx    = abs(static_cast<uint16_t>(x2 - x1));
+    const auto dy    = abs(static_cast<uint16_t>(y2 - y1));
+    auto       error = static_cast<uint16_t>(dx - dy);
+    while ((x1 != x2) && (y1 != y2))
+    {
+        const auto error2 = static_cast<uint16_t>(error + error);
+        if (greater(error2, static_cast<uint16_t>(-dy)))
+        {
+            error = static_cast<uint16_t>(error - dy);
+            x1    = static_cast<uint16_t>(x1 + sx);
+        }
+        if (less(error2, dx))
+        {
+            error = static_cast<uint16_t>(error + dx);
+            y1    = static_cast<uint16_t>(y1 + sy);
+        }
+        static_cast<void>(drawPixel(x1, y1));
+    }
+    return true;
+}
+
+bool n2t::NativeOs::drawRectangle(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)
+{
+    if (less(x1, 0) || greater(x1, 511) || less(y1, 0) || greater(y1, 255) || less(x2, 0) || greater(x2, 511) ||
+        less(y2, 0) || greater(y2, 255) || less(x2, x1) || less(y2, y1))
+    {
+        return false;
+    }
+
+    const auto powersOfTwo = variable(ScreenPowersOfTwo);
+    const auto columnMin   = *divide(x1, 16);
+    const auto columnMax   = *divide(x2, 16);
+    auto       addressMin  = static_cast<uint16_t>(screen + multiply(y1, 32) + columnMin);
+    const auto addressDiff = static_cast<uint16_t>(columnMax - columnMin);
+    const auto valueMin    = static_cast<uint16_t>(~(element(powersOfTwo, x1 & 15) - 1));
+    const auto valueMax    = static_cast<uint16_t>(element(powersOfTwo, (x2 & 15) + 1) - 1);
+    while (!greater(y1, y2))
+    {
+        const auto addressMax = static_cast<uint16_t>(addressMin + addressDiff);
+        if (addressDiff == 0)
+        {
+            updateWord(addressMin, valueMin & valueMax);
+        }
+        else
+        {
+            updateWord(addressMin, valueMin);
+            ++addressMin;
+            while (less(addressMin, addressMax))
+            {
+                updateWord(addressMin, 0xFFFF);
+                ++addressMin;
+            }
+            updateWord(addressMin, valueMax);
+        }
+        ++y1;
+        addressMin = static_cast<uint16_t>(addressMax + 32 - addressDiff);
+    }
+    return true;
+}
+
+bool n2t::NativeOs::drawCircle(uint16_t cx, uint16_t cy, uint16_t r)
+{
+    if (less(cx, 0) || greater(cx, 511) || less(cy, 0) || greater(cy, 255) || less(r, 0))
+    {
+        return false;
+    }
+
+    // a circle leaving the screen calls 'Sys.error' from 'Screen.drawLine' after drawing some of its lines
+    if ((cx < r) || ((cx + r) > 511) || (cy < r) || ((cy + r) > 255))
+    {
+        return false;
+    }
+
+    auto x     = r;
+    auto y     = uint16_t{0};
+    auto error = static_cast<uint16_t>(1 - x);
+    while (!less(x, y))
+    {
+        static_cast<void>(drawLine(x + cx, y + cy, cx - x, y + cy));
+        static_cast<void>(drawLine(y + cx, x + cy, cx - y, x + cy));
+        static_cast<void>(drawLine(x + cx, cy - y, cx - x, cy - y));
+        static_cast<void>(drawLine(y + cx, cy - x, cx - y, cy - x));
+        ++y;
+        if (less(error, 0))
+        {
+            error = static_cast<uint16_t>(error + (y + y) + 1);
+        }
+        else
+        {
+            --x;
+            const auto value = static_cast<uint16_t>(y - x + 1);
+            error            = static_cast<uint16_t>(error + value + value);
+        }
+    }
+    return true;
+}
+
+void n2t::NativeOs::updateWord(uint16_t address, uint16_t bits)
+{
+    if (holds(variable(ScreenColor)))
+    {
+        poke(address, peek(address) | bits);
+    }
+    else
+    {
+        poke(address, peek(address) & static_cast<uint16_t>(~bits));
+    }
+}
+
+bool n2t::NativeOs::moveCursor(uint16_t i, uint16_t j)
+{
+    if (less(i, 0) || greater(i, 22) || less(j, 0) || greater(j, 63))
+    {
+        return false;
+    }
+
+    variable(OutputCursorRow)        = multiply(i, 352);
+    variable(OutputCursorColumn)     = *divide(j, 2);
+    variable(OutputEvenCursorColumn) = ((j & 1) == 0) ? jackTrue : 0;
+    drawChar(' ');
+    return true;
+}
+
+void n2t::NativeOs::printChar(uint16_t c)
+{
+    if (c == newLineChar)
+    {
+        println();
+    }
+    else if (c == backSpaceChar)
+    {
+        backSpace();
+    }
+    else
+    {
+        drawChar(c);
+
+        if (holds(variable(OutputEvenCursorColumn)))
+        {
+            variable(OutputEvenCursorColumn) = 0;
+        }
+        else
+        {
+            ++variable(OutputCursorColumn);
+            variable(OutputEvenCursorColumn) = jackTrue;
+        }
+        if (greater(variable(OutputCursorColumn), 31))
+        {
+            println();
+        }
+    }
+}
+
+void n2t::NativeOs::println()
+{
+    variable(OutputCursorRow) = static_cast<uint16_t>(variable(OutputCursorRow) + 352);
+    if (greater(variable(OutputCursorRow), 7744))
+    {
+        variable(OutputCursorRow) = 0;
+    }
+    variable(OutputCursorColumn)     = 0;
+    variable(OutputEvenCursorColumn) = jackTrue;
+}
+
+void n2t::NativeOs::backSpace()
+{
+    if (holds(variable(OutputEvenCursorColumn)))
+    {
+        if (greater(variable(OutputCursorColumn), 0))
+        {
+            --variable(OutputCursorColumn);
+            variable(OutputEvenCursorColumn) = 0;
+        }
+    }
+    else
+    {
+        variable(OutputEvenCursorColumn) = jackTrue;
+    }
+    drawChar(' ');
+}
+
+void n2t::NativeOs::drawChar(uint16_t c)
+{
+    const auto charMap = getMap(c);
+    auto       address = static_cast<uint16_t>(screen + variable(OutputCursorRow) + variable(OutputCursorColumn));
+    for (uint16_t row = 0; row < 11; ++row)
+    {
+        auto charRow = element(charMap, row);
+        auto value   = peek(address);
+        if (holds(variable(OutputEvenCursorColumn)))
+        {
+            value &= 0xFF00;
+        }
+        else
+        {
+            charRow = element(variable(OutputShiftedCharRows), charRow);
+            value &= 0x00FF;
+        }
+        poke(address, charRow | value);
+        address = static_cast<uint16_t>(address + 32);
+    }
+}
+
+uint16_t n2t::NativeOs::getMap(uint16_t c)
+{
+    if (less(c, 32) || greater(c, 126))
+    {
+        c = 0;
+    }
+    return element(variable(OutputCharMaps), c);
+}
@@ -0,0 +1,151 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef N2T_NATIVE_OS_H
+#define N2T_NATIVE_OS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace n2t
+{
+// Native implementations of the OS functions of directory 12, which operate on the RAM of a VM program running the
+// same OS. Each function reads and writes the RAM, including the static variables and the arrays of the OS classes,
+// like the VM code compiled from the Jack code, so that the heap, the screen and the OS state are identical after
+// the call. Only the stack above SP, where the VM code would have left its frames, differs.
+//
+// The conditions of the Jack code are evaluated with the 16-bit wrapping comparisons of the VM commands, and a
+// function that would call 'Sys.error' does not change the RAM and returns no value, so that it is run as VM code.
+class NativeOs
+{
+public:
+    static constexpr std::size_t maxArguments = 4;
+
+    // Index of a native function.
+    enum class Function : uint8_t
+    {
+        MathAbs,
+        MathMultiply,
+        MathDivide,
+        MathSqrt,
+        MathMax,
+        MathMin,
+        MemoryPeek,
+        MemoryPoke,
+        MemoryAlloc,
+        MemoryDeAlloc,
+        ScreenClearScreen,
+        ScreenSetColor,
+        ScreenDrawPixel,
+        ScreenDrawLine,
+        ScreenDrawRectangle,
+        ScreenDrawCircle,
+        ScreenUpdateWord,
+        OutputMoveCursor,
+        OutputPrintChar,
+        OutputPrintln,
+        OutputBackSpace,
+        OutputDrawChar,
+        OutputGetMap
+    };
+
+    struct FunctionInfo
+    {
+        std::string_view name;
+        Function         function;
+        uint16_t         numArguments;
+        uint16_t         statics;  // mask of the static variables used, including by the called functions
+    };
+
+    // Returns the native functions.
+    [[nodiscard]] static std::span<const FunctionInfo> functions();
+
+    // Returns the native function 'name', if any.
+    [[nodiscard]] static const FunctionInfo* findFunction(std::string_view name);
+
+    // Resolves the addresses of the static variables used by 'function' from the 'Class.index' variables of the
+    // program.
+    void resolveStatics(const FunctionInfo& function, const std::unordered_map<std::string, uint16_t>& statics);
+
+    // Executes 'function', and returns its value, or no value if it must run as VM code instead.
+    [[nodiscard]] std::optional<uint16_t> call(Function function, uint16_t* ram, const uint16_t* arguments);
+
+private:
+    // Static variables of the OS classes, in the order of their declaration in each class.
+    enum Static : uint16_t
+    {
+        MathPowersOfTwo,
+        MathDivisors,
+        MemoryMemory,
+        MemoryFreeList,
+        ScreenColor,
+        ScreenPowersOfTwo,
+        OutputCharMaps,
+        OutputShiftedCharRows,
+        OutputCursorRow,
+        OutputCursorColumn,
+        OutputEvenCursorColumn,
+        NumStatics
+    };
+
+    [[nodiscard]] uint16_t& variable(Static variable)
+    {
+        return m_ram[m_statics[variable]];
+    }
+
+    // Element 'index' of the array at 'base'.
+    [[nodiscard]] uint16_t& element(uint16_t base, uint16_t index);
+
+    [[nodiscard]] uint16_t multiply(uint16_t x, uint16_t y);
+    [[nodiscard]] std::optional<uint16_t> divide(uint16_t x, uint16_t y);
+    [[nodiscard]] std::optional<uint16_t> sqrt(uint16_t x);
+    [[nodiscard]] uint16_t peek(uint16_t address);
+    void poke(uint16_t address, uint16_t value);
+    [[nodiscard]] std::optional<uint16_t> alloc(uint16_t size);
+    void deAlloc(uint16_t object);
+    void clearScreen();
+    [[nodiscard]] bool drawPixel(uint16_t x, uint16_t y);
+    [[nodiscard]] bool drawLine(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2);
+    [[nodiscard]] bool drawRectangle(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2);
+    [[nodiscard]] bool drawCircle(uint16_t cx, uint16_t cy, uint16_t r);
+    void updateWord(uint16_t address, uint16_t bits);
+    [[nodiscard]] bool moveCursor(uint16_t i, uint16_t j);
+    void printChar(uint16_t c);
+    void println();
+    void backSpace();
+    void drawChar(uint16_t c);
+    [[nodiscard]] uint16_t getMap(uint16_t c);
+
+    uint16_t*                        m_ram = nullptr;
+    std::array<uint16_t, NumStatics> m_statics{};
+};
+}  // namespace n2t
+
+#endif
@@ -0,0 +1,710 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "VmComputer.h"
+
+#include "Parser.h"
+
+#include <Util.h>
+
+#include <frozen/unordered_map.h>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+constexpr uint16_t addressMask     = 0x7FFF;
+constexpr uint16_t spAddress       = 0;
+constexpr uint16_t lclAddress      = 1;
+constexpr uint16_t argAddress      = 2;
+constexpr uint16_t thisAddress     = 3;
+constexpr uint16_t thatAddress     = 4;
+constexpr uint16_t r13Address      = 13;
+constexpr uint16_t r14Address      = 14;
+constexpr uint16_t firstStatic     = 16;
+constexpr uint16_t stackBase       = 256;
+constexpr uint16_t savedFrameSize  = 5;
+constexpr uint32_t bootstrapCall   = 0;  // call of 'Sys.init', which returns to the following halt
+constexpr uint32_t firstInstruction = 2;
+}  // namespace
+
+n2t::VmComputer::VmComputer(const PathList& inputFilenames) : m_ram(ramSize)
+{
+    // the bootstrap code
+    m_program.push_back(Instruction{Opcode::Call});
+    m_program.push_back(Instruction{Opcode::Halt});
+
+    std::vector<Reference> jumps;
+    std::vector<Reference> calls;
+    for (const auto& inputFilename : inputFilenames)
+    {
+        load(inputFilename, jumps, calls);
+    }
+
+    // running past the last command halts the computer
+    m_program.push_back(Instruction{Opcode::Halt});
+    throwUnless(m_program.size() <= (std::numeric_limits<uint16_t>::max() + std::size_t{1}),
+                "Program size ({}) exceeds the maximum number of commands that can be returned to ({})",
+                m_program.size(),
+                std::numeric_limits<uint16_t>::max() + 1);
+
+    for (const auto& jump : jumps)
+    {
+        const auto iter = m_labels.find(jump.name);
+        throwUnless(iter != m_labels.end(), {jump.filename, jump.lineNumber}, "Undefined label ({})", jump.name);
+
+        m_program[jump.instruction].target = iter->second;
+    }
+
+    for (const auto& jump : jumps)
+    {
+        if (isIdleLoop(jump.instruction))
+        {
+            m_program[jump.instruction].opcode = Opcode::IdleLoop;
+        }
+    }
+
+    for (const auto& call : calls)
+    {
+        const auto iter = m_functions.find(call.name);
+        throwUnless(iter != m_functions.end(), {call.filename, call.lineNumber}, "Undefined function ({})", call.name);
+        m_program[call.instruction].target = iter->second;
+    }
+
+    const auto sysInit = m_functions.find("Sys.init");
+    m_bootstrap        = (sysInit != m_functions.end());
+    if (m_bootstrap)
+    {
+        m_program[bootstrapCall].target = sysInit->second;
+    }
+    else
+    {
+        // the call has no target, and is never executed
+        m_program[bootstrapCall].opcode = Opcode::Halt;
+    }
+
+    reset();
+}
+
+void n2t::VmComputer::reset()
+{
+    std::fill(m_ram.begin(), m_ram.end(), uint16_t{0});
+    if (m_bootstrap)
+    {
+        m_ram[spAddress] = stackBase;
+    }
+    m_pc     = m_bootstrap ? bootstrapCall : firstInstruction;
+    m_cycles = 0;
+    m_halted = false;
+}
+
+// Computed goto is a GNU extension, also supported by Clang. Other compilers dispatch through a switch statement.
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(N2T_NO_COMPUTED_GOTO)
+#define N2T_COMPUTED_GOTO 1
+#else
+#define N2T_COMPUTED_GOTO 0
+#endif
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"  // labels as values
+
+uint64_t n2t::VmComputer::run(uint64_t maxCycles)
+{
+    if (m_halted)
+    {
+        return 0;
+    }
+
+    const auto* program   = m_program.data();
+    const auto  size      = static_cast<uint32_t>(m_program.size());
+    auto*       ram       = m_ram.data();
+    auto        pc        = m_pc;
+    auto        halted    = false;
+    auto        remaining = maxCycles;
+
+    // the stack operations follow the Hack code of the VM translator, so that they leave the same RAM
+    const auto push = [ram](uint16_t value) {
+        const auto sp         = ram[spAddress];
+        ram[spAddress]        = static_cast<uint16_t>(sp + 1);
+        ram[sp & addressMask] = value;
+    };
+    const auto pop = [ram] {
+        const auto sp  = static_cast<uint16_t>(ram[spAddress] - 1);
+        ram[spAddress] = sp;
+        return ram[sp & addressMask];
+    };
+    const auto top = [ram]() -> uint16_t& {
+        return ram[static_cast<uint16_t>(ram[spAddress] - 1) & addressMask];
+    };
+
+    // saves the frame of the caller, and returns the entry point of the called function
+    const auto enter = [&](const Instruction& instruction, uint32_t returnAddress) {
+        push(static_cast<uint16_t>(returnAddress));
+        push(ram[lclAddress]);
+        push(ram[argAddress]);
+        push(ram[thisAddress]);
+        push(ram[thatAddress]);
+        ram[argAddress] = static_cast<uint16_t>(ram[spAddress] - instruction.operand - savedFrameSize);
+        ram[lclAddress] = ram[spAddress];
+        return instruction.target;
+    };
+
+#if N2T_COMPUTED_GOTO
+    // in the order of the opcodes
+    static const void* const handlers[] = {&&add,
+                                           &&sub,
+                                           &&neg,
+                                           &&bitAnd,
+                                           &&bitOr,
+                                           &&bitNot,
+                                           &&eq,
+                                           &&gt,
+                                           &&lt,
+                                           &&pushConstant,
+                                           &&pushAddress,
+                                           &&pushSegment,
+                                           &&popAddress,
+                                           &&popSegment,
+                                           &&jump,
+                                           &&jumpIf,
+                                           &&idleLoop,
+                                           &&function,
+                                           &&call,
+                                           &&ret,
+                                           &&native,
+                                           &&halt};
+
+#define N2T_HANDLER(label, opcode) label:
+#define N2T_DISPATCH()                                                 \
+    if (remaining == 0)                                                \
+    {                                                                  \
+        goto stop;                                                     \
+    }                                                                  \
+    --remaining;                                                       \
+    goto* handlers[static_cast<std::size_t>(program[pc].opcode)]
+
+    N2T_DISPATCH();
+#else
+#define N2T_HANDLER(label, opcode) case Opcode::opcode:
+#define N2T_DISPATCH() continue
+
+    for (;;)
+    {
+        if (remaining == 0)
+        {
+            goto stop;
+        }
+        --remaining;
+
+        switch (program[pc].opcode)
+        {
+#endif
+
+// 'eq', 'gt' and 'lt' compare the 16-bit difference of the operands, like the Hack code of the VM translator
+#define N2T_COMPARISON(label, opcode, op)                                                   \
+    N2T_HANDLER(label, opcode)                                                              \
+    {                                                                                       \
+        const auto y = pop();                                                               \
+        auto&      x = top();                                                               \
+        x            = (static_cast<int16_t>(x - y) op 0) ? uint16_t{0xFFFF} : uint16_t{0}; \
+        ++pc;                                                                               \
+        N2T_DISPATCH();                                                                     \
+    }
+
+    N2T_HANDLER(add, Add)
+    {
+        const auto y = pop();
+        top() += y;
+        ++pc;
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(sub, Sub)
+    {
+        const auto y = pop();
+        top() -= y;
+        ++pc;
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(neg, Neg)
+    {
+        top() = static_cast<uint16_t>(-top());
+        ++pc;
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(bitAnd, And)
+    {
+        const auto y = pop();
+        top() &= y;
+        ++pc;
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(bitOr, Or)
+    {
+        const auto y = pop();
+        top() |= y;
+        ++pc;
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(bitNot, Not)
+    {
+        top() = static_cast<uint16_t>(~top());
+        ++pc;
+        N2T_DISPATCH();
+    }
+
+    N2T_COMPARISON(eq, Eq, ==)
+    N2T_COMPARISON(gt, Gt, >)
+    N2T_COMPARISON(lt, Lt, <)
+
+    N2T_HANDLER(pushConstant, PushConstant)
+    {
+        push(program[pc].operand);
+        ++pc;
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(pushAddress, PushAddress)
+    {
+        push(ram[program[pc].operand]);
+        ++pc;
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(pushSegment, PushSegment)
+    {
+        const auto& instruction = program[pc];
+        push(ram[(ram[instruction.segment] + instruction.operand) & addressMask]);
+        ++pc;
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(popAddress, PopAddress)
+    {
+        ram[program[pc].operand] = pop();
+        ++pc;
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(popSegment, PopSegment)
+    {
+        const auto& instruction = program[pc];
+        const auto  address     = static_cast<uint16_t>(ram[instruction.segment] + instruction.operand);
+        if (instruction.operand > 1)
+        {
+            ram[r13Address] = address;
+        }
+        ram[address & addressMask] = pop();
+        ++pc;
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(jump, Goto)
+    {
+        pc = program[pc].target;
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(jumpIf, IfGoto)
+    {
+        pc = (pop() != 0) ? program[pc].target : (pc + 1);
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(idleLoop, IdleLoop)
+    {
+        halted = true;
+        goto stop;
+    }
+
+    N2T_HANDLER(function, Function)
+    {
+        for (uint16_t local = 0; local < program[pc].operand; ++local)
+        {
+            push(0);
+        }
+        ++pc;
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(call, Call)
+    {
+        pc = enter(program[pc], pc + 1);
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(ret, Return)
+    {
+        const auto frame = ram[lclAddress];
+        ram[r14Address]  = ram[static_cast<uint16_t>(frame - savedFrameSize) & addressMask];
+
+        const auto value                   = pop();
+        ram[ram[argAddress] & addressMask] = value;
+        ram[spAddress]                     = static_cast<uint16_t>(ram[argAddress] + 1);
+        ram[lclAddress]                    = ram[static_cast<uint16_t>(frame - 4) & addressMask];
+        ram[argAddress]                    = ram[static_cast<uint16_t>(frame - 3) & addressMask];
+        ram[thisAddress]                   = ram[static_cast<uint16_t>(frame - 2) & addressMask];
+        ram[thatAddress]                   = ram[static_cast<uint16_t>(frame - 1) & addressMask];
+        ram[r13Address]                    = static_cast<uint16_t>(frame - 1);
+
+        // a return address outside of the loaded files, such as the zero in the frame of the outermost function of a
+        // program without 'Sys.init', leaves the program
+        pc = ram[r14Address];
+        if ((pc < firstInstruction) || (pc >= size))
+        {
+            halted = true;
+            goto stop;
+        }
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(native, Native)
+    {
+        // the value replaces the arguments, like the value returned by the VM code
+        const auto& instruction = program[pc];
+        const auto  arguments   = static_cast<uint16_t>(ram[spAddress] - instruction.operand);
+
+        std::array<uint16_t, NativeOs::maxArguments> values{};
+        for (uint16_t i = 0; i < instruction.operand; ++i)
+        {
+            values[i] = ram[(arguments + i) & addressMask];
+        }
+
+        const auto value = m_nativeOs.call(static_cast<NativeOs::Function>(instruction.segment), ram, values.data());
+        if (value)
+        {
+            ram[arguments & addressMask] = *value;
+            ram[spAddress]               = static_cast<uint16_t>(arguments + 1);
+            ++pc;
+        }
+        else
+        {
+            pc = enter(instruction, pc + 1);
+        }
+        N2T_DISPATCH();
+    }
+
+    N2T_HANDLER(halt, Halt)
+    {
+        // reaching the end of the program does not execute a command
+        ++remaining;
+        halted = true;
+        goto stop;
+    }
+
+#if !N2T_COMPUTED_GOTO
+        }
+    }
+#endif
+
+#undef N2T_HANDLER
+#undef N2T_DISPATCH
+#undef N2T_COMPARISON
+
+stop:
+    const auto cycles = maxCycles - remaining;
+
+    m_pc     = pc;
+    m_halted = halted;
+    m_cycles += cycles;
+
+    return cycles;
+}
+
+#pragma GCC diagnostic pop
+
+bool n2t::VmComputer::isIdleLoop(std::size_t jump) const
+{
+    const auto& instruction = m_program[jump];
+    if ((instruction.opcode != Opcode::Goto) || (instruction.target > jump))
+    {
+        return false;
+    }
+
+    // the loop is evaluated on its own stack, which must not reach below the stack of its first pass
+    std::vector<uint16_t> stack;
+    const auto            pop = [&stack] {
+        const auto value = stack.back();
+        stack.pop_back();
+        return value;
+    };
+
+    for (auto index = instruction.target; index < jump; ++index)
+    {
+        const auto& command = m_program[index];
+        if (command.opcode == Opcode::PushConstant)
+        {
+            stack.push_back(command.operand);
+            continue;
+        }
+
+        const auto unary = (command.opcode == Opcode::Neg) || (command.opcode == Opcode::Not);
+        if ((command.opcode == Opcode::IfGoto) || unary)
+        {
+            if (stack.empty())
+            {
+                return false;
+            }
+        }
+        else if (stack.size() < 2)
+        {
+            return false;
+        }
+
+        switch (command.opcode)
+        {
+            case Opcode::Neg:
+                stack.back() = static_cast<uint16_t>(-stack.back());
+                break;
+
+            case Opcode::Not:
+                stack.back() = static_cast<uint16_t>(~stack.back());
+                break;
+
+            case Opcode::IfGoto:
+                if (pop() != 0)
+                {
+                    // the loop may be left
+                    return false;
+                }
+                break;
+
+            case Opcode::Add:
+            case Opcode::Sub:
+            case Opcode::And:
+            case Opcode::Or:
+            case Opcode::Eq:
+            case Opcode::Gt:
+            case Opcode::Lt:
+            {
+                const auto y = pop();
+                const auto x = stack.back();
+                switch (command.opcode)
+                {
+                    case Opcode::Add:
+                        stack.back() = static_cast<uint16_t>(x + y);
+                        break;
+                    case Opcode::Sub:
+                        stack.back() = static_cast<uint16_t>(x - y);
+                        break;
+                    case Opcode::And:
+                        stack.back() = x & y;
+                        break;
+                    case Opcode::Or:
+                        stack.back() = x | y;
+                        break;
+                    case Opcode::Eq:
+                        stack.back() = (static_cast<int16_t>(x - y) == 0) ? uint16_t{0xFFFF} : uint16_t{0};
+                        break;
+                    case Opcode::Gt:
+                        stack.back() = (static_cast<int16_t>(x - y) > 0) ? uint16_t{0xFFFF} : uint16_t{0};
+                        break;
+                    default:
+                        stack.back() = (static_cast<int16_t>(x - y) < 0) ? uint16_t{0xFFFF} : uint16_t{0};
+                        break;
+                }
+                break;
+            }
+
+            default:
+                // any other command may read or change the state
+                return false;
+        }
+    }
+
+    // a pass that leaves the stack as it found it repeats forever
+    return stack.empty();
+}
+
+void n2t::VmComputer::useNativeFunction(std::string_view name)
+{
+    const auto* function = NativeOs::findFunction(name);
+    throwUnless(function != nullptr, "Function ({}) has no native implementation", name);
+
+    const auto entry = m_functions.find(std::string{name});
+    throwUnless(entry != m_functions.end(), "Function ({}) is not defined", name);
+
+    m_nativeOs.resolveStatics(*function, m_statics);
+
+    // a call with an unexpected number of arguments still runs the VM code
+    for (auto& instruction : m_program)
+    {
+        if ((instruction.opcode == Opcode::Call) && (instruction.target == entry->second) &&
+            (instruction.operand == function->numArguments))
+        {
+            instruction.opcode  = Opcode::Native;
+            instruction.segment = static_cast<uint8_t>(function->function);
+        }
+    }
+}
+
+void n2t::VmComputer::load(const std::filesystem::path& inputFilename,
+                           std::vector<Reference>&      jumps,
+                           std::vector<Reference>&      calls)
+{
+    // clang-format off
+    static constexpr auto arithmeticOpcodes = frozen::make_unordered_map<frozen::string, Opcode>(
+    {
+        {"add", Opcode::Add},
+        {"sub", Opcode::Sub},
+        {"neg", Opcode::Neg},
+        {"and", Opcode::And},
+        {"or",  Opcode::Or},
+        {"not", Opcode::Not},
+        {"eq",  Opcode::Eq},
+        {"gt",  Opcode::Gt},
+        {"lt",  Opcode::Lt}
+    });
+
+    // base pointer address of the indirect segments, or base address of the direct segments
+    struct SegmentInfo
+    {
+        SegmentType type;
+        bool        indirect;
+        uint16_t    address;
+    };
+
+    static constexpr auto segmentInfo = frozen::make_unordered_map<frozen::string, SegmentInfo>(
+    {
+        {"constant", SegmentInfo{SegmentType::Constant, false, 0}},
+        {"static",   SegmentInfo{SegmentType::Static,   false, 0}},
+        {"pointer",  SegmentInfo{SegmentType::Pointer,  false, 3}},
+        {"temp",     SegmentInfo{SegmentType::Temp,     false, 5}},
+        {"argument", SegmentInfo{SegmentType::Argument, true,  argAddress}},
+        {"local",    SegmentInfo{SegmentType::Local,    true,  lclAddress}},
+        {"this",     SegmentInfo{SegmentType::This,     true,  thisAddress}},
+        {"that",     SegmentInfo{SegmentType::That,     true,  thatAddress}}
+    });
+    // clang-format on
+
+    const auto  filename = inputFilename.filename().string();
+    const auto  prefix   = inputFilename.stem().string() + ".";
+    Parser      parser{inputFilename};
+    std::string function;
+
+    try
+    {
+        while (parser.advance())
+        {
+            Instruction instruction;
+            switch (parser.commandType())
+            {
+                case CommandType::Arithmetic:
+                {
+                    const auto iter = arithmeticOpcodes.find(toFrozenString(parser.arg1()));
+                    throwUnless(iter != arithmeticOpcodes.end(), "Invalid arithmetic command type ({})", parser.arg1());
+                    instruction.opcode = iter->second;
+                    break;
+                }
+
+                case CommandType::Push:
+                case CommandType::Pop:
+                {
+                    const auto isPush = (parser.commandType() == CommandType::Push);
+                    const auto iter   = segmentInfo.find(toFrozenString(parser.arg1()));
+                    throwUnless(iter != segmentInfo.end(), "Invalid memory segment ({})", parser.arg1());
+
+                    const auto& info  = iter->second;
+                    const auto  index = static_cast<uint16_t>(parser.arg2());
+                    if (info.type == SegmentType::Constant)
+                    {
+                        throwUnless(isPush, "Cannot pop to the constant segment");
+                        instruction.opcode  = Opcode::PushConstant;
+                        instruction.operand = index;
+                    }
+                    else if (info.indirect)
+                    {
+                        instruction.opcode  = isPush ? Opcode::PushSegment : Opcode::PopSegment;
+                        instruction.segment = static_cast<uint8_t>(info.address);
+                        instruction.operand = index;
+                    }
+                    else
+                    {
+                        instruction.opcode = isPush ? Opcode::PushAddress : Opcode::PopAddress;
+                        if (info.type == SegmentType::Static)
+                        {
+                            // the assembler allocates the variables in the order of their first use
+                            const auto address = static_cast<uint16_t>(firstStatic + m_statics.size());
+                            instruction.operand =
+                                m_statics.emplace(prefix + std::to_string(index), address).first->second;
+                        }
+                        else
+                        {
+                            instruction.operand = static_cast<uint16_t>(info.address + index);
+                        }
+                    }
+                    break;
+                }
+
+                case CommandType::Label:
+                {
+                    const auto label = function + "$" + parser.arg1();
+                    throwUnless(m_labels.emplace(label, static_cast<uint32_t>(m_program.size())).second,
+                                "Label ({}) already exists",
+                                label);
+                    continue;
+                }
+
+                case CommandType::Goto:
+                case CommandType::If:
+                    instruction.opcode = (parser.commandType() == CommandType::Goto) ? Opcode::Goto : Opcode::IfGoto;
+                    jumps.push_back(
+                        Reference{m_program.size(), function + "$" + parser.arg1(), filename, parser.lineNumber()});
+                    break;
+
+                case CommandType::Function:
+                    function = parser.arg1();
+                    throwUnless(m_functions.emplace(function, static_cast<uint32_t>(m_program.size())).second,
+                                "Function with name ({}) already exists",
+                                function);
+                    instruction.opcode  = Opcode::Function;
+                    instruction.operand = static_cast<uint16_t>(parser.arg2());
+                    break;
+
+                case CommandType::Return:
+                    instruction.opcode = Opcode::Return;
+                    break;
+
+                case CommandType::Call:
+                    instruction.opcode  = Opcode::Call;
+                    instruction.operand = static_cast<uint16_t>(parser.arg2());
+                    calls.push_back(Reference{m_program.size(), parser.arg1(), filename, parser.lineNumber()});
+                    break;
+            }
+            m_program.push_back(instruction);
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        throwAlways({filename, parser.lineNumber()}, ex.what());
+    }
+}
@@ -0,0 +1,169 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef N2T_VM_COMPUTER_H
+#define N2T_VM_COMPUTER_H
+
+#include "NativeOs.h"
+#include "VmTypes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace n2t
+{
+// Executes VM programs directly, without translating them to Hack code. The VM files are compiled into a compact
+// bytecode where the labels and the functions are resolved to instruction indices, and the memory segments to their
+// base pointer or their address.
+//
+// The stack, the memory segments and the saved frames live in the same RAM, and are updated like the Hack code of
+// the VM translator updates them, including R13 and R14 in 'pop' and 'return'. The static variables are allocated
+// from address 16 in the order of their first use, as the assembler allocates them. Only the return addresses saved
+// by 'call' differ, as they are instruction indices of the bytecode instead of ROM addresses.
+class VmComputer
+{
+public:
+    static constexpr std::size_t ramSize = 0x8000;
+
+    // Loads the VM files. A program that defines 'Sys.init' starts with a call to it after setting SP to 256, like
+    // the bootstrap code of the VM translator, and any other program starts with its first command.
+    explicit VmComputer(const PathList& inputFilenames);
+
+    // Executes the calls of the OS function 'name' with its native implementation, which changes the RAM like the VM
+    // code of the function except the stack above SP, and counts as a single command.
+    void useNativeFunction(std::string_view name);
+
+    [[nodiscard]] bool hasFunction(std::string_view name) const
+    {
+        return m_functions.contains(std::string{name});
+    }
+
+    // Clears the data memory, and restarts the program.
+    void reset();
+
+    // Executes VM commands until the program halts or 'maxCycles' commands have been executed, and returns the
+    // number of executed commands. The program halts when it returns from its outermost function or runs past its
+    // last command, or when it reaches the end of a loop that provably never exits and changes no state, such as the
+    // 'while (true) {}' loop of 'Sys.halt'.
+    uint64_t run(uint64_t maxCycles);
+
+    [[nodiscard]] bool halted() const
+    {
+        return m_halted;
+    }
+
+    [[nodiscard]] uint64_t cycles() const
+    {
+        return m_cycles;
+    }
+
+    [[nodiscard]] std::size_t programSize() const
+    {
+        return m_program.size();
+    }
+
+    [[nodiscard]] std::span<const uint16_t> ram() const
+    {
+        return m_ram;
+    }
+
+    [[nodiscard]] std::span<uint16_t> ram()
+    {
+        return m_ram;
+    }
+
+private:
+    enum class Opcode : uint8_t
+    {
+        Add,
+        Sub,
+        Neg,
+        And,
+        Or,
+        Not,
+        Eq,
+        Gt,
+        Lt,
+        PushConstant,
+        PushAddress,  // push of a static, pointer or temp variable, whose address is the operand
+        PushSegment,  // push of an argument, local, this or that variable, whose base pointer is 'segment'
+        PopAddress,
+        PopSegment,
+        Goto,
+        IfGoto,
+        IdleLoop,  // backward goto of a loop that changes no state
+        Function,
+        Call,
+        Return,
+        Native,  // call of a native function, whose index is 'segment', or of its VM code if the native call fails
+        Halt
+    };
+
+    struct Instruction
+    {
+        Opcode   opcode  = Opcode::Halt;
+        uint8_t  segment = 0;  // address of the base pointer of a segment, or index of a native function
+        uint16_t operand = 0;  // constant, address, segment index, number of locals or number of arguments
+        uint32_t target  = 0;  // instruction index of a jump or a call
+    };
+
+    // Jump or call whose target is resolved once all the files are loaded.
+    struct Reference
+    {
+        std::size_t  instruction = 0;
+        std::string  name;
+        std::string  filename;
+        unsigned int lineNumber = 0;
+    };
+
+    // Returns whether the command is a backward 'goto' that closes a loop which never exits and changes no state: a
+    // loop of constants, arithmetic commands and untaken 'if-goto' commands that leaves the stack as it found it,
+    // such as the 'while (true) {}' loop of 'Sys.halt', or a 'goto' to itself.
+    [[nodiscard]] bool isIdleLoop(std::size_t jump) const;
+
+    // Compiles a VM file, and records the jumps and calls to resolve.
+    void load(const std::filesystem::path& inputFilename,
+              std::vector<Reference>&      jumps,
+              std::vector<Reference>&      calls);
+
+    std::vector<Instruction>                  m_program;
+    std::unordered_map<std::string, uint32_t> m_functions;  // entry point of each function
+    std::unordered_map<std::string, uint32_t> m_labels;     // instruction of each 'function$label'
+    std::unordered_map<std::string, uint16_t> m_statics;    // address of each 'File.index' static variable
+    std::vector<uint16_t>                     m_ram;
+    NativeOs                                  m_nativeOs;
+    bool                                      m_bootstrap = false;
+    uint32_t                                  m_pc        = 0;
+    uint64_t                                  m_cycles    = 0;
+    bool                                      m_halted    = false;
+};
+}  // namespace n2t
+
+#endif
@@ -0,0 +1,227 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "NativeOs.h"
+#include "VmComputer.h"
+#include "VmTypes.h"
+
+#include <RamOptions.h>
+
+#include <cxxopts.hpp>
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+[[nodiscard]] n2t::PathList findInputFiles(const std::filesystem::path& inputPath)
+{
+    n2t::PathList inputFilenames;
+
+    if (std::filesystem::is_directory(inputPath))
+    {
+        for (const auto& entry : std::filesystem::directory_iterator(inputPath))
+        {
+            const auto& path = entry.path();
+            if (std::filesystem::is_regular_file(path) && (path.extension() == ".vm"))
+            {
+                inputFilenames.push_back(path);
+            }
+        }
+
+        if (inputFilenames.empty())
+        {
+            throw std::invalid_argument{
+                fmt::format("Input directory ({}) does not contain VM files", inputPath.string())};
+        }
+    }
+    else if (std::filesystem::is_regular_file(inputPath))
+    {
+        if (inputPath.extension() != ".vm")
+        {
+            throw std::invalid_argument{fmt::format("Input file ({}) is not a VM file", inputPath.string())};
+        }
+        inputFilenames.push_back(inputPath);
+    }
+    else
+    {
+        throw std::invalid_argument{
+            fmt::format("Input path ({}) is neither a file nor a directory", inputPath.string())};
+    }
+
+    return inputFilenames;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    int result = EXIT_SUCCESS;
+
+    const std::filesystem::path programPath{*argv};
+    cxxopts::Options            options{programPath.filename(), "VM Emulator"};
+
+    try
+    {
+        /*
+         * Parse command line options
+         */
+
+        uint64_t maxCycles = std::numeric_limits<uint64_t>::max();
+        bool     quiet     = false;
+
+        options.show_positional_help();
+
+        // clang-format off
+        options.add_options()
+            ("help", "Display this help message")
+            ("c,cycles", "Stop after 'arg' VM commands", cxxopts::value<uint64_t>(maxCycles))
+            ("n,native", "Run the OS functions 'arg' (e.g. Math.multiply,Screen.drawRectangle) natively, or 'all' of them", cxxopts::value<std::vector<std::string>>())
+            ("q,quiet", "Do not display the execution statistics", cxxopts::value<bool>(quiet))
+            ("r,ram", "Display the RAM word 'address' or words 'first:last' after the run", cxxopts::value<std::vector<std::string>>())
+            ("s,set", "Set the RAM word 'address=value' before the run", cxxopts::value<std::vector<std::string>>());
+
+        options.add_options("Positional")
+            ("input-path", "Input VM file/directory", cxxopts::value<std::vector<std::string>>());
+        // clang-format on
+
+        options.parse_positional("input-path");
+
+        const auto optionsMap = options.parse(argc, argv);
+
+        if (optionsMap.count("help") != 0)
+        {
+            std::cout << options.help() << '\n';
+            return EXIT_SUCCESS;
+        }
+
+        const auto inputPathCount = optionsMap.count("input-path");
+        if (inputPathCount == 0)
+        {
+            throw cxxopts::option_required_exception{"input-path"};
+        }
+        if (inputPathCount != 1)
+        {
+            throw cxxopts::OptionParseException{"Option 'input-path' is specified more than once"};
+        }
+
+        const std::filesystem::path inputPath{optionsMap["input-path"].as<std::vector<std::string>>().front()};
+        if (!std::filesystem::exists(inputPath))
+        {
+            throw std::invalid_argument{fmt::format("Input path ({}) does not exist", inputPath.string())};
+        }
+
+        std::vector<std::pair<uint16_t, uint16_t>> assignments;
+        if (optionsMap.count("set") != 0)
+        {
+            for (const auto& assignment : optionsMap["set"].as<std::vector<std::string>>())
+            {
+                assignments.push_back(n2t::parseRamAssignment(assignment, n2t::VmComputer::ramSize));
+            }
+        }
+
+        std::vector<std::pair<uint16_t, uint16_t>> ranges;
+        if (optionsMap.count("ram") != 0)
+        {
+            for (const auto& range : optionsMap["ram"].as<std::vector<std::string>>())
+            {
+                ranges.push_back(n2t::parseRamRange(range, n2t::VmComputer::ramSize));
+            }
+        }
+
+        /*
+         * Run program
+         */
+
+        n2t::VmComputer computer{findInputFiles(inputPath)};
+        if (optionsMap.count("native") != 0)
+        {
+            for (const auto& name : optionsMap["native"].as<std::vector<std::string>>())
+            {
+                if (name != "all")
+                {
+                    computer.useNativeFunction(name);
+                    continue;
+                }
+
+                // every native function of the OS classes that the program contains
+                for (const auto& function : n2t::NativeOs::functions())
+                {
+                    if (computer.hasFunction(function.name))
+                    {
+                        computer.useNativeFunction(function.name);
+                    }
+                }
+            }
+        }
+        for (const auto& [address, value] : assignments)
+        {
+            computer.ram()[address] = value;
+        }
+
+        const auto startTime   = std::chrono::steady_clock::now();
+        computer.run(maxCycles);
+        const auto elapsedTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        for (const auto& [first, last] : ranges)
+        {
+            for (auto address = first; address <= last; ++address)
+            {
+                std::cout << fmt::format("RAM[{}] = {}\n", address, static_cast<int16_t>(computer.ram()[address]));
+            }
+        }
+
+        if (!quiet)
+        {
+            std::cout << fmt::format("{} after {} commands in {:.3f} s ({:.1f} MIPS)\n",
+                                     computer.halted() ? "Halted" : "Stopped",
+                                     computer.cycles(),
+                                     elapsedTime,
+                                     (elapsedTime > 0) ? (static_cast<double>(computer.cycles()) / elapsedTime / 1e6)
+                                                       : 0.0);
+        }
+    }
+    catch (const cxxopts::OptionException& ex)
+    {
+        result = EXIT_FAILURE;
+        std::cerr << "ERROR: " << ex.what() << "\n\n";
+        std::cout << options.help() << '\n';
+    }
+    catch (const std::exception& ex)
+    {
+        result = EXIT_FAILURE;
+        std::cerr << "ERROR: " << ex.what() << '\n';
+    }
+
+    return result;
+}
@@ -0,0 +1,49 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "MappedFile.h"
+
+#include "Util.h"
+
+#include <exception>
+
+n2t::MappedFile::MappedFile(const std::filesystem::path& filename)
+{
+    try
+    {
+        m_mapping = boost::interprocess::file_mapping{filename.c_str(), boost::interprocess::read_only};
+
+        // an empty file cannot be mapped
+        if (std::filesystem::file_size(filename) != 0)
+        {
+            m_region = boost::interprocess::mapped_region{m_mapping, boost::interprocess::read_only};
+            m_region.advise(boost::interprocess::mapped_region::advice_sequential);
+            m_contents = std::string_view{static_cast<const char*>(m_region.get_address()), m_region.get_size()};
+        }
+    }
+    catch (const std::exception&)
+    {
+        throwAlways<std::runtime_error>("Could not open input file ({})", filename.string());
+    }
+}
@@ -0,0 +1,64 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef N2T_MAPPED_FILE_H
+#define N2T_MAPPED_FILE_H
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <filesystem>
+#include <string_view>
+
+namespace n2t
+{
+// Read-only memory mapping of a whole file.
+class MappedFile
+{
+public:
+    // Opens the file and maps it into memory.
+    explicit MappedFile(const std::filesystem::path& filename);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&&)      = delete;
+
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    ~MappedFile() = default;
+
+    // Returns the contents of the file, which remain valid for the lifetime of the mapping.
+    [[nodiscard]] std::string_view contents() const noexcept
+    {
+        return m_contents;
+    }
+
+private:
+    boost::interprocess::file_mapping  m_mapping;
+    boost::interprocess::mapped_region m_region;
+    std::string_view                   m_contents;
+};
+}  // namespace n2t
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "RamOptions.h"
+
+#include <cxxopts.hpp>
+
+#include <fmt/format.h>
+
+#include <charconv>
+#include <system_error>
+
+namespace
+{
+[[nodiscard]] uint16_t parseAddress(std::string_view text, std::string_view option, std::size_t ramSize)
+{
+    uint16_t   address = 0;
+    const auto result  = std::from_chars(text.data(), text.data() + text.size(), address);
+    if ((result.ec != std::errc{}) || (result.ptr != (text.data() + text.size())) || (address >= ramSize))
+    {
+        throw cxxopts::OptionParseException{fmt::format("Option '{}' has an invalid address '{}'", option, text)};
+    }
+    return address;
+}
+
+[[nodiscard]] uint16_t parseValue(std::string_view text, std::string_view option)
+{
+    int16_t    value  = 0;
+    const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if ((result.ec != std::errc{}) || (result.ptr != (text.data() + text.size())))
+    {
+        throw cxxopts::OptionParseException{fmt::format("Option '{}' has an invalid value '{}'", option, text)};
+    }
+    return static_cast<uint16_t>(value);
+}
+}  // namespace
+
+std::pair<uint16_t, uint16_t> n2t::parseRamAssignment(std::string_view text, std::size_t ramSize)
+{
+    const auto separator = text.find('=');
+    if (separator == std::string_view::npos)
+    {
+        throw cxxopts::OptionParseException{fmt::format("Option 'set' has an invalid argument '{}'", text)};
+    }
+    return {parseAddress(text.substr(0, separator), "set", ramSize), parseValue(text.substr(separator + 1), "set")};
+}
+
+std::pair<uint16_t, uint16_t> n2t::parseRamRange(std::string_view text, std::size_t ramSize)
+{
+    const auto separator = text.find(':');
+    if (separator == std::string_view::npos)
+    {
+        const auto address = parseAddress(text, "ram", ramSize);
+        return {address, address};
+    }
+
+    const auto first = parseAddress(text.substr(0, separator), "ram", ramSize);
+    const auto last  = parseAddress(text.substr(separator + 1), "ram", ramSize);
+    if (last < first)
+    {
+        throw cxxopts::OptionParseException{fmt::format("Option 'ram' has an invalid range '{}'", text)};
+    }
+    return {first, last};
+}
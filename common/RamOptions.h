@@ -0,0 +1,45 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef N2T_RAM_OPTIONS_H
+#define N2T_RAM_OPTIONS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+namespace n2t
+{
+// Parsers of the RAM arguments shared by the command line emulators, which throw cxxopts::OptionParseException on
+// an address that is not below 'ramSize' or on a malformed argument.
+
+// Parses the 'address=value' argument of the 'set' option, where the value is a signed 16-bit integer.
+[[nodiscard]] std::pair<uint16_t, uint16_t> parseRamAssignment(std::string_view text, std::size_t ramSize);
+
+// Parses the 'address' or 'first:last' argument of the 'ram' option.
+[[nodiscard]] std::pair<uint16_t, uint16_t> parseRamRange(std::string_view text, std::size_t ramSize);
+}  // namespace n2t
+
+#endif
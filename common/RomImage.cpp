@@ -0,0 +1,241 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "RomImage.h"
+
+#include "Util.h"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+namespace
+{
+constexpr std::array<char, 4> binaryMagic{'H', 'A', 'C', 'K'};
+constexpr uint16_t            binaryVersion    = 1;
+constexpr std::size_t         binaryHeaderSize = 12;
+constexpr std::size_t         wordSize         = 2;
+constexpr std::size_t         wordBits         = 16;
+
+[[nodiscard]] uint16_t readWord(const char* bytes) noexcept
+{
+    return static_cast<uint16_t>(static_cast<uint8_t>(bytes[0]) | (static_cast<uint8_t>(bytes[1]) << 8U));
+}
+
+[[nodiscard]] uint32_t readDoubleWord(const char* bytes) noexcept
+{
+    return (readWord(bytes) | (static_cast<uint32_t>(readWord(bytes + wordSize)) << wordBits));
+}
+
+void writeWord(char* bytes, uint16_t word) noexcept
+{
+    bytes[0] = static_cast<char>(word & 0xFFU);
+    bytes[1] = static_cast<char>(word >> 8U);
+}
+
+void writeDoubleWord(char* bytes, uint32_t doubleWord) noexcept
+{
+    writeWord(bytes, static_cast<uint16_t>(doubleWord & 0xFFFFU));
+    writeWord(bytes + wordSize, static_cast<uint16_t>(doubleWord >> wordBits));
+}
+
+// Binary digits of every byte value, most significant digit first.
+constexpr auto byteDigits = []
+{
+    std::array<std::array<char, CHAR_BIT>, 256> digits{};
+    for (std::size_t value = 0; value < digits.size(); ++value)
+    {
+        for (std::size_t bit = 0; bit < CHAR_BIT; ++bit)
+        {
+            digits[value][CHAR_BIT - 1 - bit] = ((value >> bit) & 1U) ? '1' : '0';
+        }
+    }
+    return digits;
+}();
+
+void writeTextImage(std::ofstream& file, std::span<const uint16_t> instructions)
+{
+    // each instruction is formatted as 16 binary digits followed by a newline
+    constexpr std::size_t lineSize  = wordBits + 1;
+    constexpr std::size_t chunkSize = 4096 * lineSize;
+
+    std::vector<char> buffer(std::min(chunkSize, instructions.size() * lineSize));
+    auto*             out = buffer.data();
+
+    for (const auto instruction : instructions)
+    {
+        const auto& high = byteDigits[instruction >> 8U];
+        const auto& low  = byteDigits[instruction & 0xFFU];
+
+        out = std::copy(high.begin(), high.end(), out);
+        out = std::copy(low.begin(), low.end(), out);
+        *out++ = '\n';
+
+        if (out == buffer.data() + buffer.size())
+        {
+            file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            out = buffer.data();
+        }
+    }
+
+    file.write(buffer.data(), out - buffer.data());
+}
+
+[[nodiscard]] bool isBinaryImage(std::string_view contents) noexcept
+{
+    return contents.starts_with(std::string_view{binaryMagic.data(), binaryMagic.size()});
+}
+
+[[nodiscard]] n2t::RomImage parseBinaryImage(std::string_view contents, const std::string& filename)
+{
+    const n2t::SourceLocation location{filename};
+
+    n2t::throwUnless(contents.size() >= binaryHeaderSize, location, "Binary file header is truncated");
+
+    const auto version = readWord(contents.data() + binaryMagic.size());
+    n2t::throwUnless(version == binaryVersion, location, "Unsupported binary file version ({})", version);
+
+    const std::size_t instructionCount = readDoubleWord(contents.data() + binaryHeaderSize - sizeof(uint32_t));
+    n2t::throwUnless(instructionCount <= n2t::romSize,
+                     location,
+                     "Instruction count ({}) exceeds the limit ({})",
+                     instructionCount,
+                     n2t::romSize);
+    n2t::throwUnless(contents.size() == (binaryHeaderSize + (instructionCount * wordSize)),
+                     location,
+                     "Binary file size does not match the instruction count ({})",
+                     instructionCount);
+
+    n2t::RomImage image(instructionCount);
+    const auto*   bytes = contents.data() + binaryHeaderSize;
+    for (auto& instruction : image)
+    {
+        instruction = readWord(bytes);
+        bytes += wordSize;
+    }
+
+    return image;
+}
+
+[[nodiscard]] n2t::RomImage parseTextImage(std::string_view contents, const std::string& filename)
+{
+    n2t::RomImage image;
+    image.reserve(contents.size() / (wordBits + 1));
+
+    unsigned int lineNumber = 0;
+    while (!contents.empty())
+    {
+        ++lineNumber;
+
+        const auto lineEnd = std::min(contents.find('\n'), contents.size());
+        auto       line    = contents.substr(0, lineEnd);
+        contents.remove_prefix(std::min(lineEnd + 1, contents.size()));
+
+        if (line.ends_with('\r'))
+        {
+            line.remove_suffix(1);
+        }
+        if (line.empty())
+        {
+            continue;
+        }
+
+        n2t::throwUnless(line.size() == wordBits,
+                         {filename, lineNumber},
+                         "Instruction ({}) does not have {} binary digits",
+                         line,
+                         wordBits);
+
+        uint16_t instruction = 0;
+        for (const auto digit : line)
+        {
+            n2t::throwUnless((digit == '0') || (digit == '1'),
+                             {filename, lineNumber},
+                             "Instruction ({}) contains a non-binary digit",
+                             line);
+
+            instruction = static_cast<uint16_t>((instruction << 1U) | static_cast<uint16_t>(digit - '0'));
+        }
+
+        n2t::throwUnless(image.size() < n2t::romSize,
+                         {filename, lineNumber},
+                         "Instruction count exceeds the limit ({})",
+                         n2t::romSize);
+
+        image.push_back(instruction);
+    }
+
+    return image;
+}
+}  // namespace
+
+n2t::RomImage n2t::loadRomImage(const std::filesystem::path& filename)
+{
+    std::ifstream file{filename, std::ios::binary};
+    throwUnless<std::runtime_error>(file.good(), "Could not open input file ({})", filename.string());
+
+    // read the whole file at once
+    std::string contents(std::filesystem::file_size(filename), '\0');
+    file.read(contents.data(), static_cast<std::streamsize>(contents.size()));
+    throwUnless<std::runtime_error>(file.good(), "Could not read input file ({})", filename.string());
+
+    const auto name = filename.filename().string();
+    return isBinaryImage(contents) ? parseBinaryImage(contents, name) : parseTextImage(contents, name);
+}
+
+void n2t::saveRomImage(const std::filesystem::path& filename,
+                       std::span<const uint16_t>    instructions,
+                       RomFormat                    format)
+{
+    std::ofstream file{filename, std::ios::binary};
+    throwUnless<std::runtime_error>(file.good(), "Could not open output file ({})", filename.string());
+
+    if (format == RomFormat::Binary)
+    {
+        std::string contents(binaryHeaderSize + (instructions.size() * wordSize), '\0');
+        auto*       bytes = contents.data();
+
+        std::copy(binaryMagic.begin(), binaryMagic.end(), bytes);
+        writeWord(bytes + binaryMagic.size(), binaryVersion);
+        writeDoubleWord(bytes + binaryHeaderSize - sizeof(uint32_t), static_cast<uint32_t>(instructions.size()));
+
+        bytes += binaryHeaderSize;
+        for (const auto instruction : instructions)
+        {
+            writeWord(bytes, instruction);
+            bytes += wordSize;
+        }
+
+        file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    }
+    else
+    {
+        writeTextImage(file, instructions);
+    }
+
+    throwUnless<std::runtime_error>(file.good(), "Could not write output file ({})", filename.string());
+}
@@ -0,0 +1,64 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef N2T_ROM_IMAGE_H
+#define N2T_ROM_IMAGE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace n2t
+{
+// Hack machine language file formats.
+//
+// The text format stores one instruction per line as 16 '0' and '1' characters.
+//
+// The binary format starts with a 12-byte header, followed by the instructions as 16-bit little-endian words:
+//
+//   offset  size  field
+//   0       4     magic number ("HACK")
+//   4       2     format version (1)
+//   6       2     reserved (0)
+//   8       4     number of instructions
+enum class RomFormat
+{
+    Text,
+    Binary
+};
+
+using RomImage = std::vector<uint16_t>;
+
+// Maximum number of instructions that can be stored in the instruction memory.
+inline constexpr std::size_t romSize = 0x8000;
+
+// Loads a ROM image from the given file, detecting its format from the file contents.
+[[nodiscard]] RomImage loadRomImage(const std::filesystem::path& filename);
+
+// Saves a ROM image to the given file in the given format.
+void saveRomImage(const std::filesystem::path& filename, std::span<const uint16_t> instructions, RomFormat format);
+}  // namespace n2t
+
+#endif
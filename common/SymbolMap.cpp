@@ -0,0 +1,112 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "SymbolMap.h"
+
+#include "MappedFile.h"
+#include "Util.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+n2t::SymbolMap n2t::loadSymbolMap(const std::filesystem::path& filename)
+{
+    const MappedFile file{filename};
+    const auto       name     = filename.filename().string();
+    auto             contents = file.contents();
+
+    SymbolMap    symbols;
+    unsigned int lineNumber = 0;
+    while (!contents.empty())
+    {
+        ++lineNumber;
+
+        const auto lineEnd = std::min(contents.find('\n'), contents.size());
+        auto       line    = contents.substr(0, lineEnd);
+        contents.remove_prefix(std::min(lineEnd + 1, contents.size()));
+
+        if (line.ends_with('\r'))
+        {
+            line.remove_suffix(1);
+        }
+        if (line.empty())
+        {
+            continue;
+        }
+
+        // <address> <kind> <symbol>
+        const auto addressEnd = line.find(' ');
+        throwUnless((addressEnd != std::string_view::npos) && (line.size() > (addressEnd + 3)) &&
+                        (line[addressEnd + 2] == ' '),
+                    {name, lineNumber},
+                    "Invalid symbol map entry ({})",
+                    line);
+
+        SymbolMapEntry entry;
+
+        const auto address = line.substr(0, addressEnd);
+        const auto result  = std::from_chars(address.data(), address.data() + address.size(), entry.address, 16);
+        throwUnless((result.ec == std::errc{}) && (result.ptr == (address.data() + address.size())),
+                    {name, lineNumber},
+                    "Invalid address ({}) in symbol map entry",
+                    address);
+
+        const auto kind = line[addressEnd + 1];
+        throwUnless((kind == 'L') || (kind == 'V'),
+                    {name, lineNumber},
+                    "Invalid symbol kind ({}) in symbol map entry",
+                    kind);
+        entry.kind = (kind == 'L') ? SymbolKind::Label : SymbolKind::Variable;
+
+        entry.symbol = line.substr(addressEnd + 3);
+        symbols.push_back(std::move(entry));
+    }
+
+    return symbols;
+}
+
+void n2t::saveSymbolMap(const std::filesystem::path& filename, const SymbolMap& symbols)
+{
+    fmt::memory_buffer buffer;
+    for (const auto& entry : symbols)
+    {
+        fmt::format_to(std::back_inserter(buffer),
+                       "{:04X} {} {}\n",
+                       entry.address,
+                       (entry.kind == SymbolKind::Label) ? 'L' : 'V',
+                       entry.symbol);
+    }
+
+    std::ofstream file{filename, std::ios::binary};
+    throwUnless<std::runtime_error>(file.good(), "Could not open output file ({})", filename.string());
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    throwUnless<std::runtime_error>(file.good(), "Could not write output file ({})", filename.string());
+}
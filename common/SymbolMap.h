@@ -0,0 +1,63 @@
+/*
+ * This file is part of Nand2Tetris.
+ *
+ * Copyright © 2013-2020 Jonathan Miller
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef N2T_SYMBOL_MAP_H
+#define N2T_SYMBOL_MAP_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace n2t
+{
+// A symbol map lists the labels and variables of an assembled program, one symbol per line:
+//
+//   <address> <kind> <symbol>
+//
+// where the address is four hexadecimal digits, and the kind is 'L' for a label (ROM address) or 'V' for a
+// variable (RAM address). Labels are listed before variables, and each kind is sorted by address.
+enum class SymbolKind
+{
+    Label,
+    Variable
+};
+
+struct SymbolMapEntry
+{
+    std::string symbol;
+    uint16_t    address = 0;
+    SymbolKind  kind    = SymbolKind::Label;
+};
+
+using SymbolMap = std::vector<SymbolMapEntry>;
+
+// Loads a symbol map from the given file.
+[[nodiscard]] SymbolMap loadSymbolMap(const std::filesystem::path& filename);
+
+// Saves a symbol map to the given file, writing the entries in the given order.
+void saveSymbolMap(const std::filesystem::path& filename, const SymbolMap& symbols);
+}  // namespace n2t
+
+#endif